@@ -0,0 +1,185 @@
+#include "BackgroundSaver.h"
+#include <utility>
+#include "Stats.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <system_error>
+#include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * Negative lock timeout, waiting for the list as long as it takes.
+     */
+    constexpr std::chrono::milliseconds noTimeout{-1};
+
+#ifndef _WIN32
+    /**
+     * The pipe the signal handler writes the number of the signal to, read by the thread waiting for signals.
+     */
+    int signalPipe[2] = {-1, -1};
+    constexpr int handledSignals[] = {SIGINT, SIGTERM, SIGHUP};
+
+    void onSignal(int signal) {
+        // Writing to a pipe is one of the few things a signal handler may do.
+        auto byte = static_cast<unsigned char>(signal);
+        (void) ::write(signalPipe[1], &byte, 1);
+    }
+#endif
+}
+
+BackgroundSaver::BackgroundSaver(PasswordList &list, std::chrono::milliseconds delay)
+        : list(list), delay(delay), thread([this] { run(); }) {}
+
+BackgroundSaver::~BackgroundSaver() {
+#ifndef _WIN32
+    if (signalThread.joinable()) {
+        for (int signal : handledSignals) std::signal(signal, SIG_DFL);
+        // A zero byte tells the thread to stop waiting.
+        unsigned char stop = 0;
+        (void) ::write(signalPipe[1], &stop, 1);
+        signalThread.join();
+        ::close(signalPipe[0]);
+        ::close(signalPipe[1]);
+        signalPipe[0] = signalPipe[1] = -1;
+    }
+#endif
+    {
+        std::lock_guard guard(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+std::unique_lock<std::timed_mutex> BackgroundSaver::lock() {
+    return std::unique_lock(listMutex);
+}
+
+void BackgroundSaver::markDirty() {
+    auto taken = list.takeChanges();
+    {
+        std::lock_guard guard(mutex);
+        changes += taken.data;
+        ++version;
+    }
+    wake.notify_one();
+}
+
+bool BackgroundSaver::dirty() {
+    std::lock_guard guard(mutex);
+    return version != savedVersion;
+}
+
+void BackgroundSaver::flush(bool compact) {
+    std::unique_lock guard(mutex);
+    auto id = ++flushesAsked;
+    compactAsked = compactAsked || compact;
+    wake.notify_one();
+    saved.wait(guard, [&] { return flushesDone >= id; });
+    if (error) std::rethrow_exception(error);
+}
+
+void BackgroundSaver::flushUrgently() {
+    std::unique_lock guard(mutex);
+    urgent = true;
+    auto id = ++flushesAsked;
+    wake.notify_one();
+    saved.wait(guard, [&] { return flushesDone >= id; });
+}
+
+std::uint64_t BackgroundSaver::saveCount() {
+    std::lock_guard guard(mutex);
+    return writes;
+}
+
+std::optional<std::uint64_t> BackgroundSaver::save(bool compact, std::chrono::milliseconds lockTimeout) {
+    std::unique_lock listLock(listMutex, std::defer_lock);
+    if (lockTimeout < std::chrono::milliseconds::zero()) {
+        listLock.lock();
+    } else {
+        (void) listLock.try_lock_for(lockTimeout);
+    }
+    bool locked = listLock.owns_lock();
+    // Changes are only marked while the list is locked, so with the lock held the version matches the list.
+    PasswordList::PendingSave pending;
+    std::uint64_t target;
+    {
+        std::lock_guard guard(mutex);
+        pending.data = std::exchange(changes, string());
+        target = version;
+    }
+    if (locked) {
+        pending = list.prepareSave(compact, std::move(pending.data));
+        listLock.unlock();
+    }
+    if (pending.rewrite || !pending.data.empty()) {
+        STATS_TIMER(timer, "BackgroundSaver::save");
+        list.finishSave(pending);
+        std::lock_guard guard(mutex);
+        ++writes;
+    }
+    // Without the lock it is unknown whether the list needs a rewrite, so the changes only count once it was locked.
+    return locked ? std::optional(target) : std::nullopt;
+}
+
+void BackgroundSaver::run() {
+    std::unique_lock guard(mutex);
+    while (true) {
+        wake.wait(guard, [&] { return stopping || flushesAsked != flushesDone || version != savedVersion; });
+        if (!stopping && flushesAsked == flushesDone) {
+            // Wait for the burst of changes to end, but save at last if it goes on.
+            auto deadline = std::chrono::steady_clock::now() + delay * maxDelays;
+            for (auto seen = version; std::chrono::steady_clock::now() < deadline; seen = version) {
+                bool woken = wake.wait_for(guard, delay, [&] {
+                    return stopping || flushesAsked != flushesDone || version != seen;
+                });
+                if (!woken || stopping || flushesAsked != flushesDone) break;
+            }
+        }
+        auto flushes = flushesAsked;
+        bool compact = std::exchange(compactAsked, false);
+        // Flushes are asked for by threads that do not hold the list, so they can wait for it; regular saves give up
+        // after a delay and come back, so a thread waiting for the saver never waits for a locked list.
+        auto timeout = urgent ? delay : flushes != flushesDone || stopping ? noTimeout : delay;
+        guard.unlock();
+        std::optional<std::uint64_t> covered;
+        std::exception_ptr failure;
+        try {
+            covered = save(compact, timeout);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        guard.lock();
+        error = failure;
+        if (covered && *covered > savedVersion) savedVersion = *covered;
+        if (failure && compact) compactAsked = true;
+        flushesDone = flushes;
+        saved.notify_all();
+        if (stopping) return;
+        if (failure || !covered) {
+            // Whatever went wrong, trying again at once would not help.
+            wake.wait_for(guard, delay, [&] { return stopping || flushesAsked != flushesDone; });
+        }
+    }
+}
+
+#ifndef _WIN32
+void BackgroundSaver::flushOnSignals() {
+    if (::pipe(signalPipe) != 0) throw std::system_error(errno, std::generic_category(), "Failed to create a pipe");
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    for (int signal : handledSignals) sigaction(signal, &action, nullptr);
+    signalThread = std::thread([this] {
+        unsigned char signal = 0;
+        while (::read(signalPipe[0], &signal, 1) < 0 && errno == EINTR) {}
+        if (signal == 0) return;
+        flushUrgently();
+        std::_Exit(128 + signal);
+    });
+}
+#endif
@@ -0,0 +1,155 @@
+#ifndef PASSWORDMANAGER_BACKGROUNDSAVER_H
+#define PASSWORDMANAGER_BACKGROUNDSAVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "PasswordList.h"
+
+/**
+* @brief Class saving a password list on a background thread, so changing it does not wait for the disk.
+* Whoever changes the list holds lock() while doing so and calls markDirty() once done. Every change raises the
+* version of the list; the saver waits until no change came for a short delay, so a burst of changes is written at
+* once, and saves up to the version it saw. The changes themselves are taken from the journal by markDirty(), so
+* they can be written even while the list is locked for a long time. The saver only locks the list to check if the
+* file has to be rewritten and, if so, to encrypt a consistent copy of it; the files are written without the lock.
+*/
+class BackgroundSaver {
+public:
+    /**
+     * Time without changes after which the changes are saved.
+     */
+    static constexpr std::chrono::milliseconds defaultDelay{200};
+    /**
+     * Number of delays after which changes are saved even if more keep coming.
+     */
+    static constexpr int maxDelays = 10;
+private:
+    PasswordList& list;
+    std::chrono::milliseconds delay;
+    /**
+     * Guards the password list.
+     */
+    std::timed_mutex listMutex;
+    /**
+     * Guards the members below.
+     */
+    std::mutex mutex;
+    /**
+     * Signals the saver that there is something to do.
+     */
+    std::condition_variable wake;
+    /**
+     * Signals the waiting threads that a save finished.
+     */
+    std::condition_variable saved;
+    /**
+     * The version of the list, raised by every change.
+     */
+    std::uint64_t version = 0;
+    /**
+     * The version the last successful save covered.
+     */
+    std::uint64_t savedVersion = 0;
+    /**
+     * The changes taken from the journal by markDirty() that were not written yet, in order.
+     */
+    string changes;
+    /**
+     * Number of flushes asked for, and number of the last one done.
+     */
+    std::uint64_t flushesAsked = 0, flushesDone = 0;
+    /**
+     * Whether one of the flushes asked for compacts the journal.
+     */
+    bool compactAsked = false;
+    /**
+     * Whether the list may be locked for at most a delay, because the program is about to end.
+     */
+    bool urgent = false;
+    bool stopping = false;
+    /**
+     * The error of the last save, or null if it succeeded.
+     */
+    std::exception_ptr error;
+    std::uint64_t writes = 0;
+    std::thread thread;
+#ifndef _WIN32
+    /**
+     * The thread waiting for signals, if flushOnSignals() was called.
+     */
+    std::thread signalThread;
+#endif
+    /**
+    @brief Saves changes until the saver is stopped.
+    */
+    void run();
+    /**
+    @brief Saves the changes made so far. Called without holding the mutex.
+    @param compact Whether to compact the journal into the file.
+    @param lockTimeout How long to wait for the list, or a negative duration to wait as long as it takes.
+    @return The version the save covered, or an empty optional if the list could not be locked, so only the changes
+     taken by markDirty() were written.
+    @throws std::system_error If the files could not be written.
+    */
+    std::optional<std::uint64_t> save(bool compact, std::chrono::milliseconds lockTimeout);
+public:
+    /**
+    @brief Constructs a BackgroundSaver and starts its thread.
+    @param list The password list to save. Must outlive the saver, and only be saved through it from now on.
+    @param delay Time without changes after which the changes are saved.
+    */
+    explicit BackgroundSaver(PasswordList& list, std::chrono::milliseconds delay = defaultDelay);
+    /**
+    @brief Saves the remaining changes and stops the thread. Errors of this last save are ignored.
+    */
+    ~BackgroundSaver();
+    BackgroundSaver(const BackgroundSaver&) = delete;
+    BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+    /**
+    @brief Locks the password list, for reading or changing it while the saver runs.
+    @return The lock, held until it is destroyed.
+    */
+    std::unique_lock<std::timed_mutex> lock();
+    /**
+    @brief Records that the password list was changed. Must be called while holding lock(), after the change.
+    */
+    void markDirty();
+    /**
+    @brief Checks if there are changes that were not saved yet.
+    @return True if the list is dirty, false otherwise.
+    */
+    bool dirty();
+    /**
+    @brief Saves every change made so far without waiting for the delay, and waits until it is written.
+     Must not be called while holding lock().
+    @param compact Whether to compact the journal into the file, as PasswordList::compact() does.
+    @throws std::system_error If the files could not be written.
+    */
+    void flush(bool compact = false);
+    /**
+    @brief Saves what can be saved quickly when the program is about to end: the changes taken by markDirty() are
+     always written, while a rewrite of the file only waits for the list for a delay.
+    */
+    void flushUrgently();
+    /**
+    @brief Retrieves the number of saves that wrote something, which is smaller than the number of changes when
+     bursts of them are coalesced.
+    @return The number of saves.
+    */
+    std::uint64_t saveCount();
+#ifndef _WIN32
+    /**
+    @brief Makes SIGINT, SIGTERM and SIGHUP save the password list with flushUrgently() before the program ends.
+     Only one saver of the program can do so.
+    */
+    void flushOnSignals();
+#endif
+};
+
+
+#endif //PASSWORDMANAGER_BACKGROUNDSAVER_H
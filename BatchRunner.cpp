@@ -0,0 +1,266 @@
+#include "BatchRunner.h"
+#include <charconv>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include "Stats.h"
+
+BatchRunner::BatchRunner(PasswordList &passwordList) : passwordList(passwordList) {}
+
+EntryField BatchRunner::parseField(std::string_view name, bool allowPassword) {
+    if (name == "name") return EntryField::Name;
+    if (name == "login") return EntryField::Login;
+    if (name == "website") return EntryField::Website;
+    if (name == "password" && allowPassword) return EntryField::Password;
+    throw std::invalid_argument("Unknown field " + string(name));
+}
+
+ExchangeFormat BatchRunner::parseFormat(std::string_view name) {
+    if (name == "csv") return ExchangeFormat::Csv;
+    if (name == "jsonl") return ExchangeFormat::JsonLines;
+    throw std::invalid_argument("Unknown format " + string(name) + ", expected csv or jsonl");
+}
+
+void BatchRunner::checkValue(std::string_view value, bool required) {
+    if (required && value.empty()) throw std::invalid_argument("Missing value");
+    if (!PasswordList::isStorable(value)) {
+        throw std::invalid_argument("Values cannot be longer than " + std::to_string(EntryStore::maxFieldSize) +
+                                    " bytes");
+    }
+}
+
+template <typename EntryView>
+void BatchRunner::appendEntry(string &json, const EntryView &entry) {
+    if (!json.ends_with('[')) json += ',';
+    const std::pair<const char*, std::string_view> fields[] = {
+            {"{\"category\":", entry.getCategory()}, {",\"name\":", entry.getName()},
+            {",\"password\":", entry.getPassword()}, {",\"login\":", entry.getLogin()},
+            {",\"website\":", entry.getWebsite()}};
+    for (const auto& [key, value] : fields) {
+        json += key;
+        EntryWriter::appendJson(json, value);
+    }
+    json += '}';
+}
+
+void BatchRunner::execute(const vector<std::string_view> &arguments, string &result) {
+    auto command = arguments[0];
+    auto count = arguments.size() - 1;
+    auto expect = [&](std::size_t min, std::size_t max) {
+        if (count < min || count > max) {
+            throw std::invalid_argument("Wrong number of arguments for " + string(command));
+        }
+    };
+    auto argument = [&](std::size_t i) { return i <= count ? string(arguments[i]) : string(); };
+    auto index = [&](const string& category, const string& name) {
+        auto result = passwordList.indexInCategory(category, name);
+        if (result < 0) throw std::invalid_argument("No entry " + name + " in category " + category);
+        return result;
+    };
+
+    if (command == "add") {
+        expect(3, 5);
+        auto category = argument(1), name = argument(2);
+        checkValue(category, true);
+        checkValue(name, true);
+        for (std::size_t i = 3; i <= count; ++i) checkValue(arguments[i], i == 3);
+        if (passwordList.entryExists(name, category)) {
+            throw std::invalid_argument("Entry " + name + " already exists in category " + category);
+        }
+        passwordList.addEntry(Entry(category, name, argument(3), argument(4), argument(5)));
+        return;
+    }
+    if (command == "remove") {
+        expect(2, 2);
+        auto category = argument(1);
+        passwordList.removeEntry(category, index(category, argument(2)));
+        return;
+    }
+    if (command == "move") {
+        expect(3, 3);
+        auto category = argument(1), name = argument(2), newCategory = argument(3);
+        auto position = index(category, name);
+        checkValue(newCategory, true);
+        if (passwordList.entryExists(name, newCategory)) {
+            throw std::invalid_argument("Entry " + name + " already exists in category " + newCategory);
+        }
+        passwordList.editEntry(category, position, EntryField::Category, newCategory);
+        return;
+    }
+    if (command == "edit") {
+        expect(4, 4);
+        auto category = argument(1), name = argument(2), value = argument(4);
+        auto field = parseField(arguments[3], true);
+        auto position = index(category, name);
+        checkValue(value, field == EntryField::Name || field == EntryField::Password);
+        if (field == EntryField::Name && value != name && passwordList.entryExists(value, category)) {
+            throw std::invalid_argument("Entry " + value + " already exists in category " + category);
+        }
+        passwordList.editEntry(category, position, field, value);
+        return;
+    }
+    if (command == "get") {
+        expect(2, 2);
+        result += ",\"entries\":[";
+        if (auto entry = passwordList.findEntry(arguments[1], arguments[2])) appendEntry(result, *entry);
+        result += ']';
+        return;
+    }
+    if (command == "find") {
+        expect(2, 2);
+        auto field = parseField(arguments[1], false);
+        result += ",\"entries\":[";
+        for (const auto& entry : passwordList.findEntries(field, arguments[2])) {
+            appendEntry(result, entry);
+        }
+        result += ']';
+        return;
+    }
+    if (command == "search") {
+        expect(1, 2);
+        if (count == 2 && arguments[2] != "prefix") throw std::invalid_argument("Unknown search mode");
+        auto mode = count == 2 ? SearchMode::Prefix : SearchMode::Substring;
+        result += ",\"entries\":[";
+        for (const auto& match : passwordList.search(arguments[1], mode)) {
+            appendEntry(result, match.entry);
+        }
+        result += ']';
+        return;
+    }
+    if (command == "list") {
+        expect(0, 1);
+        // Entries are listed in the order they are saved in: by category, then in the order they were added.
+        auto categories = count == 1 ? vector<string>{argument(1)} : passwordList.getCategories();
+        result += ",\"entries\":[";
+        for (const auto& category : categories) {
+            for (const auto& entry : passwordList.getEntriesInCategory(category)) {
+                appendEntry(result, entry);
+            }
+        }
+        result += ']';
+        return;
+    }
+    if (command == "categories") {
+        expect(0, 0);
+        result += ",\"categories\":[";
+        for (const auto& category : passwordList.getCategories()) {
+            if (!result.ends_with('[')) result += ',';
+            EntryWriter::appendJson(result, category);
+        }
+        result += ']';
+        return;
+    }
+    if (command == "add-category") {
+        expect(1, 1);
+        checkValue(arguments[1], true);
+        passwordList.addCategory(argument(1));
+        return;
+    }
+    if (command == "remove-category") {
+        expect(1, 1);
+        if (!passwordList.categoryExists(argument(1))) {
+            throw std::invalid_argument("No category " + argument(1));
+        }
+        passwordList.removeCategory(argument(1));
+        return;
+    }
+    if (command == "import" || command == "export") {
+        expect(1, 2);
+        auto fileName = argument(1);
+        auto format = count == 2 ? parseFormat(arguments[2]) : exchangeFormatOf(fileName);
+        if (!format) {
+            throw std::invalid_argument("Unknown file format of " + fileName +
+                                        ", expected .csv or .jsonl or a format argument");
+        }
+        if (command == "export") {
+            std::ofstream file(fileName, std::ios::binary);
+            if (!file) throw std::invalid_argument("Failed to create " + fileName);
+            auto exported = passwordList.exportEntries(file, *format);
+            if (!file.flush()) throw std::invalid_argument("Failed to write " + fileName);
+            result += ",\"exported\":" + std::to_string(exported);
+            return;
+        }
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) throw std::invalid_argument("Failed to open " + fileName);
+        try {
+            auto imported = passwordList.importEntries(file, *format);
+            result += ",\"added\":" + std::to_string(imported.added) + ",\"duplicates\":" +
+                      std::to_string(imported.duplicates) + ",\"rejected\":" + std::to_string(imported.rejected);
+        } catch (const std::runtime_error& e) {
+            throw std::invalid_argument(fileName + ": " + e.what());
+        }
+        return;
+    }
+    if (command == "rotate") {
+        expect(1, 2);
+        auto category = argument(1);
+        if (!passwordList.categoryExists(category)) throw std::invalid_argument("No category " + category);
+        auto length = rotatedLength;
+        if (count == 2) {
+            auto text = arguments[2];
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), length);
+            if (error != std::errc() || end != text.data() + text.size() || length == 0 ||
+                length > EntryStore::maxFieldSize) {
+                throw std::invalid_argument("Invalid password length " + argument(2));
+            }
+        }
+        auto size = passwordList.getEntryCount(category);
+        // All passwords are generated at once, and handed to the entries one by one through a single buffer, so
+        // wiping both leaves no copy of them behind.
+        string passwords, password;
+        generator.generate(length, size, passwords);
+        for (std::size_t i = 0; i < size; ++i) {
+            password.assign(passwords, i * length, length);
+            passwordList.editEntry(category, static_cast<int>(i), EntryField::Password, password);
+        }
+        passwords.assign(passwords.size(), '\0');
+        password.assign(password.size(), '\0');
+        result += ",\"entries\":[";
+        for (const auto& entry : passwordList.getEntriesInCategory(category)) {
+            appendEntry(result, entry);
+        }
+        result += ']';
+        return;
+    }
+    throw std::invalid_argument("Unknown command " + string(command));
+}
+
+void BatchRunner::split(std::string_view line, vector<std::string_view> &arguments) {
+    arguments.clear();
+    while (true) {
+        auto tab = line.find('\t');
+        arguments.push_back(line.substr(0, tab));
+        if (tab == std::string_view::npos) break;
+        line.remove_prefix(tab + 1);
+    }
+}
+
+std::size_t BatchRunner::run(std::istream &input, std::ostream &output, std::size_t firstLine) {
+    std::size_t failed = 0;
+    std::size_t lineNumber = firstLine - 1;
+    string line;
+    string result;
+    vector<std::string_view> arguments;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        STATS_TIMER(timer, "BatchRunner::execute");
+        split(line, arguments);
+        string members;
+        result = "{\"line\":" + std::to_string(lineNumber);
+        try {
+            execute(arguments, members);
+            result += ",\"ok\":true" + members;
+        } catch (const std::logic_error& e) {
+            // Invalid arguments, and fields too long for the store.
+            ++failed;
+            result += ",\"ok\":false,\"error\":";
+            EntryWriter::appendJson(result, e.what());
+        }
+        result += "}\n";
+        output << result;
+    }
+    return failed;
+}
@@ -0,0 +1,112 @@
+#ifndef PASSWORDMANAGER_BATCHRUNNER_H
+#define PASSWORDMANAGER_BATCHRUNNER_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PasswordGenerator.h"
+#include "PasswordList.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Class running commands against a password list without prompting, for scripts and bulk changes.
+* Commands are read one per line, with their arguments separated by tabs:
+*
+*     add <category> <name> <password> [<login> [<website>]]
+*     remove <category> <name>
+*     move <category> <name> <new category>
+*     edit <category> <name> <name|password|login|website> <value>
+*     get <category> <name>
+*     find <name|login|website> <value>
+*     search <text> [prefix]
+*     list [<category>]
+*     categories
+*     add-category <category>
+*     remove-category <category>
+*     rotate <category> [<length>]
+*     import <file> [csv|jsonl]
+*     export <file> [csv|jsonl]
+*
+* rotate replaces the password of every entry of the category with a generated one, rotatedLength characters long
+* unless a length is given, and reports the entries with their new passwords.
+* import adds the entries of a file and reports how many were "added", skipped as "duplicates" of entries already in
+* the list, and "rejected" because they could not be stored. export writes every entry to a file and reports how many
+* were "exported". The format of the file is taken from its extension (.csv, or .jsonl and .ndjson for JSON Lines)
+* unless it is given.
+*
+* Empty lines and lines starting with '#' are skipped. Every command produces one line of JSON:
+* {"line":N,"ok":true} with an "entries" array for queries and a "categories" array for categories, or
+* {"line":N,"ok":false,"error":"..."}.
+* Nothing is saved by the runner; the caller saves the password list once all commands have run.
+*/
+class BatchRunner {
+public:
+    /**
+     * Length of the passwords rotate generates when no length is given.
+     */
+    static constexpr std::size_t rotatedLength = 20;
+private:
+    /**
+     * The password list the commands are run against.
+     */
+    PasswordList& passwordList;
+    /**
+     * Generator of the passwords of rotated entries.
+     */
+    PasswordGenerator generator;
+    /**
+    @brief Parses the name of a field given as a command argument.
+    @throws std::invalid_argument If the name is not one of the allowed fields.
+    */
+    static EntryField parseField(std::string_view name, bool allowPassword);
+    /**
+    @brief Parses the name of an exchange format given as a command argument.
+    @throws std::invalid_argument If the name is neither csv nor jsonl.
+    */
+    static ExchangeFormat parseFormat(std::string_view name);
+    /**
+    @brief Checks that a value can be stored in the vault.
+    @throws std::invalid_argument If the value is empty while required or cannot be stored.
+    */
+    static void checkValue(std::string_view value, bool required);
+    /**
+    @brief Appends an entry, given as an Entry or an EntryRef, to a JSON array of entries that is being written.
+    */
+    template <typename EntryView>
+    static void appendEntry(string& json, const EntryView& entry);
+public:
+    /**
+    @brief Constructs a runner.
+    @param passwordList The password list to run the commands against.
+    */
+    explicit BatchRunner(PasswordList& passwordList);
+    /**
+    @brief Runs one command.
+    @param arguments The command name followed by its arguments.
+    @param result The string the JSON members describing the result are appended to, each preceded by a comma:
+     the entries a query found, the categories, or the counts of an import or export.
+    @throws std::invalid_argument If the command is unknown, its arguments are invalid or it cannot be applied.
+    @throws std::length_error If a value is too long to be stored.
+    */
+    void execute(const vector<std::string_view>& arguments, string& result);
+    /**
+    @brief Splits a command line into the command name and its arguments, at every tab.
+    @param line The command line.
+    @param arguments Receives views of the name and the arguments, in place of its previous contents.
+    */
+    static void split(std::string_view line, vector<std::string_view>& arguments);
+    /**
+    @brief Runs the commands read from a stream until it ends, writing one result per command.
+    @param input The stream to read the commands from.
+    @param output The stream to write the results to.
+    @param firstLine The number reported for the first line read, if lines were read from the stream before.
+    @return The number of commands that failed.
+    */
+    std::size_t run(std::istream& input, std::ostream& output, std::size_t firstLine = 1);
+};
+
+
+#endif //PASSWORDMANAGER_BATCHRUNNER_H
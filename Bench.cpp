@@ -0,0 +1,1267 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "BackgroundSaver.h"
+#include "BatchRunner.h"
+#include "BinaryVault.h"
+#include "ChaCha20.h"
+#include "DecryptionException.h"
+#include "EntryExchange.h"
+#include "PasswordGenerator.h"
+#include "PasswordList.h"
+#include "FileEncryptor.h"
+#include "LookupClient.h"
+#include "LookupServer.h"
+#include "SharedPasswordList.h"
+#include "VaultFile.h"
+#include "VaultManager.h"
+#include "VaultHeader.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using std::string, std::vector, std::cout, std::cerr;
+
+/**
+* @brief The measurements of one benchmark, together with the parameters it ran with.
+*/
+struct Result {
+    string name;
+    vector<std::pair<string, std::variant<double, string>>> params;
+    /**
+     * Duration of every sample in nanoseconds.
+     */
+    vector<double> samples = {};
+    /**
+     * Number of bytes processed by every sample, used to report throughput.
+     */
+    std::size_t bytesPerSample = 0;
+    /**
+     * Values measured once rather than sampled.
+     */
+    vector<std::pair<string, double>> counters = {};
+};
+
+/**
+ * The results of all benchmarks that ran.
+ */
+static vector<Result> results;
+/**
+ * Only benchmarks whose name contains this text are run.
+ */
+static string filter;
+
+/**
+@brief Checks if a benchmark was selected on the command line.
+*/
+static bool selected(const string& name) {
+    return name.find(filter) != string::npos;
+}
+
+/**
+@brief Runs a function and measures how long it took.
+@return The duration in nanoseconds.
+*/
+template<typename Function>
+static double timed(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+@brief Chooses how many times an operation over the whole vault is sampled, so large vaults do not take forever.
+*/
+static int samplesFor(std::size_t entries) {
+    return static_cast<int>(std::clamp<std::size_t>(2'000'000 / std::max<std::size_t>(entries, 1), 3, 30));
+}
+
+/**
+@brief Creates the synthetic entry with the given number.
+@param i The number of the entry.
+@return An entry in one of 16 categories, sharing its website with every thousandth entry.
+*/
+static Entry syntheticEntry(std::size_t i) {
+    auto id = std::to_string(i);
+    return {"category" + std::to_string(i % 16), "name" + id, "p@ssw0rd" + id, "user" + id,
+            "www.site" + std::to_string(i % 1000) + ".com"};
+}
+
+/**
+@brief Creates a vault with the given number of synthetic entries spread over a handful of categories.
+@param fileName The file to write the vault to.
+@param password The password used to encrypt the vault.
+@param count The number of entries to generate.
+*/
+static void generateVault(const string& fileName, const string& password, std::size_t count) {
+    std::filesystem::remove(fileName);
+    std::filesystem::remove(fileName + ".journal");
+    auto list = PasswordList(fileName, password);
+    for (std::size_t i = 0; i < count; ++i) {
+        list.addEntry(syntheticEntry(i));
+    }
+    list.saveData();
+}
+
+/**
+@brief Measures the operations of a password list of the given size: unlocking, saving, lookups and listing.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchVault(const string& fileName, const string& password, std::size_t size) {
+    auto samples = samplesFor(size);
+    auto entries = static_cast<double>(size);
+    if (selected("unlock")) {
+        Result result{"unlock", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timed([&] { PasswordList(fileName, password); }));
+        }
+        result.bytesPerSample = std::filesystem::file_size(fileName);
+        results.push_back(std::move(result));
+    }
+    if (selected("unlock_wrong_password")) {
+        Result result{"unlock_wrong_password", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timed([&] {
+                try {
+                    PasswordList(fileName, password + "x");
+                } catch (const DecryptionException&) {
+                    return;
+                }
+                cerr << "unlock_wrong_password: the wrong password was accepted\n";
+            }));
+        }
+        results.push_back(std::move(result));
+    }
+    auto list = PasswordList(fileName, password);
+    if (selected("save_journal")) {
+        Result result{"save_journal", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            list.editEntry("category0", i, EntryField::Password, "journaled" + std::to_string(i));
+            result.samples.push_back(timed([&] { list.saveData(); }));
+        }
+        results.push_back(std::move(result));
+    }
+    if (selected("compact")) {
+        Result result{"compact", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            list.editEntry("category0", i, EntryField::Password, "compacted" + std::to_string(i));
+            result.samples.push_back(timed([&] { list.compact(); }));
+        }
+        result.bytesPerSample = std::filesystem::file_size(fileName);
+        results.push_back(std::move(result));
+    }
+    if (selected("compact_all")) {
+        // Every category changed, so every segment is encoded again, as every compaction did before segments.
+        Result result{"compact_all", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            for (const auto& category : list.getCategories()) {
+                list.editEntry(category, i, EntryField::Password, "compacted" + std::to_string(i));
+            }
+            result.samples.push_back(timed([&] { list.compact(); }));
+        }
+        result.bytesPerSample = std::filesystem::file_size(fileName);
+        results.push_back(std::move(result));
+    }
+    if (selected("encrypt_data")) {
+        Result result{"encrypt_data", {{"entries", entries}}};
+        std::size_t bytes = 0;
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timed([&] {
+                list.invalidateLayout();
+                bytes = list.prepareSave(true).data.size();
+            }));
+        }
+        result.bytesPerSample = bytes;
+        results.push_back(std::move(result));
+    }
+    if (selected("entry_exists")) {
+        Result result{"entry_exists", {{"entries", entries}}};
+        std::mt19937 random(42);
+        std::size_t found = 0;
+        // Warm up the index, which is built on the first lookup.
+        list.entryExists("name0", "category0");
+        for (int i = 0; i < 20'000; ++i) {
+            auto id = random() % (size * 2 + 1);
+            auto name = "name" + std::to_string(id);
+            auto category = "category" + std::to_string(id % 16);
+            result.samples.push_back(timed([&] { found += list.entryExists(name, category); }));
+        }
+        result.counters.emplace_back("hits", found);
+        results.push_back(std::move(result));
+    }
+    if (selected("get_all_entries")) {
+        Result result{"get_all_entries", {{"entries", entries}}};
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timed([&] { list.getAllEntries(); }));
+        }
+        results.push_back(std::move(result));
+    }
+    if (selected("sort_compare_entries")) {
+        Result result{"sort_compare_entries", {{"entries", entries}, {"fields", "website,name"}}};
+        for (int i = 0; i < samples; ++i) {
+            auto all = list.getAllEntries();
+            result.samples.push_back(timed([&] {
+                std::sort(all.begin(), all.end(), [](const Entry& a, const Entry& b) {
+                    return Entry::compareEntries(a, b, 4, 1);
+                });
+            }));
+        }
+        results.push_back(std::move(result));
+    }
+    if (selected("sorted_view")) {
+        Result result{"sorted_view", {{"entries", entries}, {"fields", "website,name"}}};
+        std::size_t checksum = 0;
+        auto visit = [&](const EntryRef& entry) { checksum += entry.getName().size(); };
+        result.counters.emplace_back("build_ns", timed([&] {
+            list.forEachSorted(EntryField::Website, EntryField::Name, visit);
+        }));
+        for (int i = 0; i < samples; ++i) {
+            result.samples.push_back(timed([&] { list.forEachSorted(EntryField::Website, EntryField::Name, visit); }));
+        }
+        result.counters.emplace_back("update_ns", timed([&] {
+            list.editEntry("category0", 0, EntryField::Website, "www.edited.com");
+        }));
+        results.push_back(std::move(result));
+    }
+}
+
+/**
+@brief Measures how the time to unlock a vault changes with the number of threads loading it.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchParallelLoad(const string& fileName, const string& password, std::size_t size) {
+    if (!selected("unlock_threads")) return;
+    auto maxThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 4);
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        // The calling thread takes part in loading, so the pool needs one thread less.
+        ThreadPool pool(threads - 1);
+        Result result{"unlock_threads", {{"entries", static_cast<double>(size)}, {"threads", static_cast<double>(threads)}}};
+        for (int i = 0; i < samplesFor(size); ++i) {
+            result.samples.push_back(timed([&] { PasswordList(fileName, password, pool); }));
+        }
+        result.bytesPerSample = std::filesystem::file_size(fileName);
+        results.push_back(std::move(result));
+    }
+}
+
+/**
+@brief Writes a copy of a vault in the text layout used before version 3 of the vault header.
+@param list The password list to copy.
+@param fileName The file to write the copy to.
+@param password The password of the vault.
+*/
+static void writeTextVault(PasswordList& list, const string& fileName, const string& password) {
+    auto header = VaultHeader::generate(password);
+    header.version = VaultHeader::binaryVersion - 1;
+    string content;
+    header.appendTo(content);
+    for (const auto& entry : list.getAllEntries()) {
+        content += entry.getFileString();
+        content += '\n';
+    }
+    if (content.size() > header.storedSize()) content.pop_back();
+    auto payload = std::as_writable_bytes(std::span(content)).subspan(header.storedSize());
+    CipherEngine::create(header.cipher, password)->apply(payload, payload, 0);
+    std::filesystem::remove(fileName + ".journal");
+    VaultFile(fileName).write(content);
+}
+
+/**
+@brief Compares unlocking a vault stored in the text layout with the binary layout, and measures reading a single
+category of the binary layout through its directory.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchFormats(const string& fileName, const string& password, std::size_t size) {
+    auto entries = static_cast<double>(size);
+    if (selected("unlock_format")) {
+        const string textName = fileName + ".text";
+        {
+            auto list = PasswordList(fileName, password);
+            writeTextVault(list, textName, password);
+        }
+        for (auto [format, name] : {std::pair{"text", textName}, std::pair{"binary", fileName}}) {
+            Result result{"unlock_format", {{"entries", entries}, {"format", format}}};
+            for (int i = 0; i < samplesFor(size); ++i) {
+                result.samples.push_back(timed([&] { PasswordList(name, password); }));
+            }
+            result.bytesPerSample = std::filesystem::file_size(name);
+            results.push_back(std::move(result));
+        }
+        std::filesystem::remove(textName);
+        std::filesystem::remove(textName + ".journal");
+    }
+    if (selected("read_category")) {
+        Result result{"read_category", {{"entries", entries}}};
+        std::size_t bytes = 0;
+        for (int i = 0; i < samplesFor(size); ++i) {
+            result.samples.push_back(timed([&] {
+                auto mapping = VaultFile(fileName).map();
+                auto header = VaultHeader::read(mapping.data());
+                auto engine = CipherEngine::create(header->cipher, password);
+                BinaryVault::Reader reader(mapping.data().subspan(header->storedSize()), *engine, *header);
+                // The synthetic entries are spread over 16 categories; one of them is read.
+                const auto& blocks = reader.blocks();
+                auto category = std::ranges::find(reader.categories(), "category3") - reader.categories().begin();
+                auto first = std::ranges::find(blocks, category, &BinaryVault::Block::category) - blocks.begin();
+                auto last = std::find_if(blocks.begin() + first, blocks.end(), [&](const auto& block) {
+                    return block.category != category;
+                }) - blocks.begin();
+                EntryStore part;
+                reader.read(first, last, part);
+                bytes = blocks[last - 1].offset + blocks[last - 1].size - blocks[first].offset;
+            }));
+        }
+        result.bytesPerSample = bytes;
+        results.push_back(std::move(result));
+    }
+}
+
+/**
+@brief Compares keeping passwords in plain text with sealing them: unlocking, and reading passwords of random entries,
+which mostly misses the cache of decrypted passwords.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchStorage(const string& fileName, const string& password, std::size_t size) {
+    auto entries = static_cast<double>(size);
+    for (auto [storage, name] : {std::pair{PasswordStorage::Plain, "plain"},
+                                 std::pair{PasswordStorage::Sealed, "sealed"}}) {
+        if (selected("unlock_storage")) {
+            Result result{"unlock_storage", {{"entries", entries}, {"storage", name}}};
+            for (int i = 0; i < samplesFor(size); ++i) {
+                result.samples.push_back(timed([&] {
+                    PasswordList(fileName, password, ThreadPool::shared(), storage);
+                }));
+            }
+            result.bytesPerSample = std::filesystem::file_size(fileName);
+            results.push_back(std::move(result));
+        }
+        if (selected("read_password")) {
+            auto list = PasswordList(fileName, password, ThreadPool::shared(), storage);
+            std::mt19937 random(1);
+            Result result{"read_password", {{"entries", entries}, {"storage", name}}};
+            std::size_t total = 0;
+            for (int i = 0; i < 30; ++i) {
+                result.samples.push_back(timed([&] {
+                    for (int lookup = 0; lookup < 1000; ++lookup) {
+                        auto id = random() % size;
+                        auto entry = list.findEntry("category" + std::to_string(id % 16), "name" + std::to_string(id));
+                        total += entry->getPassword().size();
+                    }
+                }));
+            }
+            if (total == 0) cerr << "read_password: no password was read\n";
+            results.push_back(std::move(result));
+        }
+    }
+}
+
+/**
+@brief Compares the codecs the records of a vault can be compressed with: the size of the file, and the time taken
+to rewrite it and to unlock it.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchCompression(const string& fileName, const string& password, std::size_t size) {
+    if (!selected("save_compression") && !selected("unlock_compression")) return;
+    auto entries = static_cast<double>(size);
+    for (auto [codec, name] : {std::pair{Compression::None, "none"}, std::pair{Compression::Lz4, "lz4"}}) {
+        const string copyName = fileName + "." + name;
+        std::filesystem::copy_file(fileName, copyName, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::remove(copyName + ".journal");
+        {
+            auto list = PasswordList(copyName, password);
+            list.setCompression(codec);
+            list.compact();
+            if (selected("save_compression")) {
+                Result result{"save_compression", {{"entries", entries}, {"codec", name}}};
+                for (int i = 0; i < samplesFor(size); ++i) {
+                    result.samples.push_back(timed([&] {
+                        list.invalidateLayout();
+                        list.compact();
+                    }));
+                }
+                result.bytesPerSample = std::filesystem::file_size(copyName);
+                results.push_back(std::move(result));
+            }
+        }
+        if (selected("unlock_compression")) {
+            Result result{"unlock_compression", {{"entries", entries}, {"codec", name}}};
+            for (int i = 0; i < samplesFor(size); ++i) {
+                result.samples.push_back(timed([&] { PasswordList(copyName, password); }));
+            }
+            result.bytesPerSample = std::filesystem::file_size(copyName);
+            results.push_back(std::move(result));
+        }
+        std::filesystem::remove(copyName);
+        std::filesystem::remove(copyName + ".journal");
+    }
+}
+
+/**
+@brief Compares how long a menu action waits when every change is saved at once and when it is handed to a
+BackgroundSaver. The edits are large, so saving them at once compacts the journal into the vault now and then.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchEditSave(const string& fileName, const string& password, std::size_t size) {
+    if (!selected("edit_save")) return;
+    constexpr int edits = 2000;
+    const string copyName = fileName + ".edits";
+    const string padding(512, 'x');
+    for (string mode : {"sync", "background"}) {
+        std::filesystem::copy_file(fileName, copyName, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::remove(copyName + ".journal");
+        Result result{"edit_save", {{"entries", static_cast<double>(size)}, {"mode", mode}}};
+        auto list = PasswordList(copyName, password);
+        auto count = list.getEntryCount("category0");
+        auto edit = [&](int i) {
+            list.editEntry("category0", static_cast<std::size_t>(i) % count, EntryField::Password,
+                           padding + std::to_string(i));
+        };
+        if (mode == "sync") {
+            for (int i = 0; i < edits; ++i) {
+                result.samples.push_back(timed([&] { edit(i); list.saveData(); }));
+            }
+            result.counters.emplace_back("saves", edits);
+        } else {
+            BackgroundSaver saver(list);
+            for (int i = 0; i < edits; ++i) {
+                result.samples.push_back(timed([&] {
+                    auto lock = saver.lock();
+                    edit(i);
+                    saver.markDirty();
+                }));
+            }
+            result.counters.emplace_back("flush_ns", timed([&] { saver.flush(); }));
+            result.counters.emplace_back("saves", static_cast<double>(saver.saveCount()));
+        }
+        results.push_back(std::move(result));
+    }
+    std::filesystem::remove(copyName);
+    std::filesystem::remove(copyName + ".journal");
+}
+
+/**
+@brief Builds a provisioning script: service credentials are added, and some are edited, looked up and removed.
+@param count The number of credentials to add.
+@return The commands, one per line.
+*/
+static string batchScript(std::size_t count) {
+    string script;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto id = std::to_string(i);
+        script += "add\tservices\tsvc" + id + "\tk3y" + id + "\tsvc-user" + id + "\thost" + id + ".example\n";
+        if (i % 5 == 4) script += "edit\tservices\tsvc" + id + "\tpassword\trotated" + id + "\n";
+        if (i % 10 == 9) script += "get\tservices\tsvc" + id + "\n";
+        if (i % 20 == 19) script += "remove\tservices\tsvc" + std::to_string(i - 10) + "\n";
+    }
+    return script;
+}
+
+/**
+@brief Measures the throughput of batch mode against saving after every command, as the menu does.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchBatch(const string& fileName, const string& password, std::size_t size) {
+    if (!selected("batch")) return;
+    const string copyName = fileName + ".batch";
+    auto fresh = [&] {
+        std::filesystem::copy_file(fileName, copyName, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::remove(copyName + ".journal");
+    };
+    auto commands = [](const string& script) { return static_cast<double>(std::ranges::count(script, '\n')); };
+
+    auto script = batchScript(5000);
+    Result batch{"batch", {{"entries", static_cast<double>(size)}, {"commands", commands(script)}}};
+    for (int i = 0; i < 3; ++i) {
+        fresh();
+        auto list = PasswordList(copyName, password);
+        std::ostringstream output;
+        batch.samples.push_back(timed([&] {
+            std::istringstream input(script);
+            BatchRunner(list).run(input, output);
+            list.saveData();
+        }));
+    }
+    auto median = [](vector<double> samples) {
+        std::ranges::sort(samples);
+        return samples[samples.size() / 2];
+    };
+    batch.counters.emplace_back("ops_per_sec", commands(script) / median(batch.samples) * 1e9);
+    results.push_back(std::move(batch));
+
+    // Saving after every command is far slower, so a shorter script is enough to measure it.
+    script = batchScript(250);
+    Result eachSaved{"batch_save_each", {{"entries", static_cast<double>(size)}, {"commands", commands(script)}}};
+    for (int i = 0; i < 3; ++i) {
+        fresh();
+        auto list = PasswordList(copyName, password);
+        std::ostringstream output;
+        eachSaved.samples.push_back(timed([&] {
+            std::istringstream input(script);
+            string line;
+            while (std::getline(input, line)) {
+                std::istringstream command(line);
+                BatchRunner(list).run(command, output);
+                list.saveData();
+            }
+        }));
+    }
+    eachSaved.counters.emplace_back("ops_per_sec", commands(script) / median(eachSaved.samples) * 1e9);
+    results.push_back(std::move(eachSaved));
+    std::filesystem::remove(copyName);
+    std::filesystem::remove(copyName + ".journal");
+}
+
+/**
+@brief Measures exporting the entries of a vault to CSV and JSON Lines files and importing them into an empty one.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchExchange(const string& fileName, const string& password, std::size_t size) {
+    const std::pair<const char*, ExchangeFormat> formats[] = {{"csv", ExchangeFormat::Csv},
+                                                              {"jsonl", ExchangeFormat::JsonLines}};
+    auto list = PasswordList(fileName, password);
+    for (const auto& [name, format] : formats) {
+        if (!selected("export") && !selected("import")) continue;
+        auto exchangeName = fileName + "." + name;
+        Result exported{"export", {{"entries", static_cast<double>(size)}, {"format", name}}};
+        for (int i = 0; i < samplesFor(size); ++i) {
+            exported.samples.push_back(timed([&] {
+                std::ofstream file(exchangeName, std::ios::binary);
+                list.exportEntries(file, format);
+            }));
+        }
+        exported.bytesPerSample = std::filesystem::file_size(exchangeName);
+        if (selected("export")) results.push_back(std::move(exported));
+
+        Result imported{"import", {{"entries", static_cast<double>(size)}, {"format", name}}};
+        const string importName = fileName + ".import";
+        for (int i = 0; i < samplesFor(size); ++i) {
+            std::filesystem::remove(importName);
+            auto target = PasswordList(importName, password);
+            imported.samples.push_back(timed([&] {
+                std::ifstream file(exchangeName, std::ios::binary);
+                target.importEntries(file, format);
+            }));
+        }
+        imported.bytesPerSample = std::filesystem::file_size(exchangeName);
+        if (selected("import")) results.push_back(std::move(imported));
+        std::filesystem::remove(exchangeName);
+        std::filesystem::remove(importName);
+    }
+}
+
+/**
+@brief Compares the heap used by the entries of a vault when stored as Entry objects and in the password list.
+@param fileName The file holding the synthetic vault.
+@param password The password of the vault.
+@param size The number of entries in the vault.
+*/
+static void benchMemory(const string& fileName, const string& password, std::size_t size) {
+#ifdef __GLIBC__
+    if (!selected("memory")) return;
+    auto heapInUse = [] { return static_cast<double>(mallinfo2().uordblks); };
+    auto base = heapInUse();
+    double objects;
+    {
+        // The layout the password list used before the entry store: one object with 5 strings per entry.
+        std::deque<std::optional<Entry>> entries;
+        for (std::size_t i = 0; i < size; ++i) {
+            entries.emplace_back(syntheticEntry(i));
+        }
+        objects = heapInUse() - base;
+    }
+    base = heapInUse();
+    double stored;
+    {
+        auto list = PasswordList(fileName, password);
+        stored = heapInUse() - base;
+    }
+    results.push_back({"memory", {{"entries", static_cast<double>(size)}}, {}, 0,
+                       {{"entry_objects_bytes", objects}, {"password_list_bytes", stored}}});
+#endif
+}
+
+/**
+@brief Measures opening and searching a growing number of vaults at once through a VaultManager.
+@param entries The number of entries of every vault.
+*/
+static void benchVaults(std::size_t entries) {
+    if (!selected("open_vaults") && !selected("search_vaults")) return;
+    const auto directory = std::filesystem::temp_directory_path() / "PasswordManagerBenchVaults";
+    std::filesystem::create_directories(directory);
+    vector<VaultManager::Credentials> all;
+    for (std::size_t count : {1, 4, 16, 32}) {
+        while (all.size() < count) {
+            auto id = std::to_string(all.size());
+            all.push_back({(directory / ("vault" + id + ".txt")).string(), "benchmark" + id});
+            generateVault(all.back().fileName, all.back().password, entries);
+        }
+        const vector<VaultManager::Credentials> vaults(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(count));
+        const vector<std::pair<string, std::variant<double, string>>> params = {
+                {"vaults", static_cast<double>(count)}, {"entries", static_cast<double>(entries)}};
+        if (selected("open_vaults")) {
+            Result result{"open_vaults", params};
+            for (int i = 0; i < samplesFor(count * entries); ++i) {
+                VaultManager manager;
+                result.samples.push_back(timed([&] { manager.open(vaults); }));
+            }
+            for (const auto& vault : vaults) result.bytesPerSample += std::filesystem::file_size(vault.fileName);
+            results.push_back(std::move(result));
+        }
+        if (selected("search_vaults")) {
+            VaultManager manager;
+            manager.open(vaults);
+            // The first search builds the search index of every vault.
+            manager.search("site42");
+            Result result{"search_vaults", params};
+            std::size_t matches = 0;
+            for (int i = 0; i < 100; ++i) {
+                result.samples.push_back(timed([&] { matches = manager.search("site42").size(); }));
+            }
+            result.counters.emplace_back("matches", matches);
+            results.push_back(std::move(result));
+        }
+    }
+    std::filesystem::remove_all(directory);
+}
+
+/**
+@brief Measures how long full-text searches take and how much keeping the search index current costs.
+@param size The number of entries to search.
+*/
+static void benchSearch(std::size_t size) {
+    if (!selected("search")) return;
+    const string fileName = (std::filesystem::temp_directory_path() / "PasswordManagerSearch.txt").string();
+    std::filesystem::remove(fileName);
+    auto list = PasswordList(fileName, "benchmark");
+    for (std::size_t i = 0; i < size; ++i) {
+        list.addEntry(syntheticEntry(i));
+    }
+    auto build = timed([&] { list.search("build"); });
+    results.push_back({"search_index_build", {{"entries", static_cast<double>(size)}}, {build}});
+
+    const std::pair<string, SearchMode> queries[] = {
+            {"name" + std::to_string(size / 2), SearchMode::Substring}, {"ser12345", SearchMode::Substring},
+            {"SITE42.", SearchMode::Substring}, {"category1", SearchMode::Prefix},
+            {"www", SearchMode::Prefix}, {"e7", SearchMode::Substring}};
+    for (const auto& [query, mode] : queries) {
+        Result result{"search", {{"entries", static_cast<double>(size)}, {"query", query},
+                                 {"mode", mode == SearchMode::Prefix ? "prefix" : "substring"}}};
+        std::size_t matches = 0;
+        for (int i = 0; i < 20; ++i) {
+            result.samples.push_back(timed([&] { matches = list.search(query, mode).size(); }));
+        }
+        result.counters.emplace_back("matches", matches);
+        results.push_back(std::move(result));
+    }
+
+    Result update{"search_index_update", {{"entries", static_cast<double>(size)}}};
+    auto count = static_cast<int>(list.getEntryCount("category0"));
+    for (int i = 0; i < 1000; ++i) {
+        update.samples.push_back(timed([&] {
+            list.editEntry("category0", i % count, EntryField::Login, "edited" + std::to_string(i));
+        }));
+    }
+    results.push_back(std::move(update));
+    std::filesystem::remove(fileName);
+}
+
+/**
+@brief Measures the read throughput of snapshots of a SharedPasswordList as the number of reader threads grows, with
+ and without a writer changing the list meanwhile, and how long publishing a change takes.
+@param size The number of entries to read.
+*/
+static void benchSnapshots(std::size_t size) {
+    if (!selected("snapshot")) return;
+    const string fileName = (std::filesystem::temp_directory_path() / "PasswordManagerSnapshots.txt").string();
+    std::filesystem::remove(fileName);
+    auto list = PasswordList(fileName, "benchmark");
+    for (std::size_t i = 0; i < size; ++i) {
+        list.addEntry(syntheticEntry(i));
+    }
+    std::optional<SharedPasswordList> shared;
+    auto build = timed([&] { shared.emplace(list); });
+    results.push_back({"snapshot_build", {{"entries", static_cast<double>(size)}}, {build}});
+
+    Result publish{"snapshot_publish", {{"entries", static_cast<double>(size)}}};
+    auto count = static_cast<int>(list.getEntryCount("category0"));
+    for (int i = 0; i < 200; ++i) {
+        publish.samples.push_back(timed([&] {
+            shared->editEntry("category0", i % count, EntryField::Password, "edited" + std::to_string(i));
+        }));
+    }
+    results.push_back(std::move(publish));
+
+    constexpr std::size_t lookups = 20'000;
+    constexpr std::size_t searches = 2;
+    auto edited = static_cast<int>(list.getEntryCount("category1"));
+    for (string workload : {"lookup", "search"}) {
+        for (string writer : {"idle", "editing"}) {
+            for (std::size_t threads : {1, 2, 4, 8}) {
+                Result result{"snapshot_reads", {{"entries", static_cast<double>(size)}, {"workload", workload},
+                                                 {"writer", writer}, {"threads", static_cast<double>(threads)}}};
+                auto reads = workload == "lookup" ? lookups : searches;
+                std::size_t edits = 0;
+                for (int sample = 0; sample < 5; ++sample) {
+                    std::atomic<bool> reading = true;
+                    std::thread editor;
+                    if (writer == "editing") {
+                        editor = std::thread([&] {
+                            for (int i = 0; reading; ++i, ++edits) {
+                                shared->editEntry("category1", i % edited, EntryField::Login,
+                                                  "edited" + std::to_string(i));
+                            }
+                        });
+                    }
+                    result.samples.push_back(timed([&] {
+                        vector<std::thread> readers;
+                        for (std::size_t t = 0; t < threads; ++t) {
+                            readers.emplace_back([&, t] {
+                                std::shared_ptr<const VaultSnapshot> snapshot;
+                                std::mt19937 random(static_cast<std::uint32_t>(t));
+                                for (std::size_t i = 0; i < reads; ++i) {
+                                    shared->renew(snapshot);
+                                    if (workload == "lookup") {
+                                        auto n = random() % size;
+                                        auto entry = snapshot->findEntry("category" + std::to_string(n % 16),
+                                                                         "name" + std::to_string(n));
+                                        if (!entry) std::abort();
+                                    } else {
+                                        (void) snapshot->search("site" + std::to_string(random() % 1000) + ".");
+                                    }
+                                }
+                            });
+                        }
+                        for (auto& reader : readers) reader.join();
+                    }));
+                    reading = false;
+                    if (editor.joinable()) editor.join();
+                }
+                auto fastest = *std::ranges::min_element(result.samples);
+                result.counters.emplace_back("reads_per_s", static_cast<double>(threads * reads) / fastest * 1e9);
+                result.counters.emplace_back("edits", static_cast<double>(edits));
+                results.push_back(std::move(result));
+            }
+        }
+    }
+    shared.reset();
+    std::filesystem::remove(fileName);
+}
+
+/**
+@brief Checks that a snapshot holds the same categories and entries as a password list, in the same order.
+*/
+static bool sameContents(PasswordList& list, const VaultSnapshot& snapshot) {
+    auto categories = list.getCategories();
+    if (categories != snapshot.getCategories()) return false;
+    std::size_t total = 0;
+    for (const auto& category : categories) {
+        auto expected = list.getEntriesInCategory(category);
+        auto actual = snapshot.getEntriesInCategory(category);
+        if (expected.size() != actual.size()) return false;
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i].getFileString() != actual[i].getFileString()) return false;
+        }
+        total += expected.size();
+    }
+    return total == snapshot.size();
+}
+
+/**
+@brief Checks that a snapshot agrees with itself: every entry is found by name, every password decrypts, the size
+ counts every entry and sorting visits every entry.
+*/
+static bool consistent(const VaultSnapshot& snapshot) {
+    std::size_t total = 0;
+    for (const auto& category : snapshot.getCategories()) {
+        for (const auto& entry : snapshot.getEntriesInCategory(category)) {
+            auto found = snapshot.findEntry(category, entry.getName());
+            if (!found || found->getFileString() != entry.getFileString()) return false;
+            if (!entry.getPassword().starts_with("stress")) return false;
+            ++total;
+        }
+    }
+    std::size_t sorted = 0;
+    snapshot.forEachSorted(EntryField::Login, EntryField::Name, [&](const Entry&) { ++sorted; });
+    return total == snapshot.size() && sorted == total;
+}
+
+/**
+@brief Stress tests SharedPasswordList: a writer applies random changes of every kind while reader threads check the
+ snapshots they read, and after every change the latest snapshot is compared with the password list. Meant to be run
+ in a build with PASSWORDMANAGER_TSAN, where ThreadSanitizer reports any data race between the writer and the
+ readers.
+@return True if every snapshot was consistent, false otherwise.
+*/
+static bool benchSnapshotStress() {
+    if (!selected("snapshot_stress")) return true;
+    constexpr int operations = 2000;
+    constexpr std::size_t readerCount = 4;
+    const string fileName = (std::filesystem::temp_directory_path() / "PasswordManagerStress.txt").string();
+    bool passed = true;
+    for (auto storage : {PasswordStorage::Sealed, PasswordStorage::Plain}) {
+        std::filesystem::remove(fileName);
+        auto list = PasswordList(fileName, "benchmark", ThreadPool::shared(), storage);
+        for (int i = 0; i < 200; ++i) {
+            auto id = std::to_string(i);
+            list.addEntry(Entry("c" + std::to_string(i % 5), "n" + id, "stress" + id, "l" + std::to_string(i % 7),
+                                "w" + std::to_string(i % 3)));
+        }
+        SharedPasswordList shared(list, storage);
+        std::atomic<bool> writing = true;
+        std::atomic<std::size_t> reads = 0, failures = 0;
+        vector<std::thread> readers;
+        for (std::size_t r = 0; r < readerCount; ++r) {
+            readers.emplace_back([&, r] {
+                auto snapshot = shared.snapshot();
+                std::uint64_t last = 0;
+                while (writing) {
+                    // Half the readers keep their snapshot between reads, the other half take a new one every time.
+                    if (r % 2 == 0) snapshot = shared.snapshot();
+                    else shared.renew(snapshot);
+                    if (snapshot->version() < last || !consistent(*snapshot)) ++failures;
+                    last = snapshot->version();
+                    (void) snapshot->search("n1");
+                    (void) snapshot->findEntries(EntryField::Login, "l3");
+                    ++reads;
+                }
+            });
+        }
+        std::mt19937 random(42);
+        int next = 1000;
+        Result result{"snapshot_stress", {{"storage", storage == PasswordStorage::Sealed ? "sealed" : "plain"},
+                                          {"readers", static_cast<double>(readerCount)}}};
+        result.samples.push_back(timed([&] {
+            for (int op = 0; op < operations; ++op) {
+                auto categories = list.getCategories();
+                auto category = categories.empty() ? string("c0") : categories[random() % categories.size()];
+                auto count = list.getEntryCount(category);
+                auto index = count == 0 ? 0 : static_cast<int>(random() % count);
+                auto other = "c" + std::to_string(random() % 7);
+                auto value = std::to_string(next++);
+                switch (random() % 8) {
+                    case 0 :
+                    case 1 : shared.addEntry(Entry(other, "n" + value, "stress" + value, "l" + value, "w")); break;
+                    case 2 : if (count != 0) shared.removeEntry(category, index); break;
+                    case 3 : {
+                        if (count != 0) shared.editEntry(category, index, EntryField::Password, "stress" + value);
+                        break;
+                    }
+                    case 4 : if (count != 0) shared.editEntry(category, index, EntryField::Category, other); break;
+                    case 5 : if (count != 0) shared.moveEntry(other, list.getEntriesInCategory(category)[index]); break;
+                    case 6 : {
+                        auto field = random() % 2 == 0 ? EntryField::Login : EntryField::Name;
+                        if (count != 0) shared.editEntry(category, index, field, "x" + value);
+                        break;
+                    }
+                    default : {
+                        if (random() % 10 == 0) {
+                            shared.removeCategory(category);
+                        } else if (random() % 10 == 0) {
+                            std::istringstream input("category,name,password,login,website\nc9,i" + value +
+                                                     ",stress" + value + ",l,w\n");
+                            shared.importEntries(input, ExchangeFormat::Csv);
+                        } else {
+                            shared.addCategory("c" + std::to_string(random() % 8));
+                        }
+                    }
+                }
+                if (!sameContents(list, *shared.snapshot())) ++failures;
+            }
+        }));
+        writing = false;
+        for (auto& reader : readers) reader.join();
+        result.counters.emplace_back("operations", operations);
+        result.counters.emplace_back("reads", static_cast<double>(reads));
+        result.counters.emplace_back("failures", static_cast<double>(failures));
+        if (failures != 0) {
+            cerr << "snapshot_stress: " << failures << " inconsistent snapshots\n";
+            passed = false;
+        }
+        results.push_back(std::move(result));
+    }
+    std::filesystem::remove(fileName);
+    std::filesystem::remove(fileName + ".journal");
+    return passed;
+}
+
+#ifdef __linux__
+/**
+@brief Measures the requests per second and the latencies of a LookupServer as the number of clients grows.
+@param size The number of entries of the served vault.
+*/
+static void benchDaemon(std::size_t size) {
+    if (!selected("lookup_daemon")) return;
+    const auto directory = std::filesystem::temp_directory_path();
+    const string fileName = (directory / "PasswordManagerDaemon.txt").string();
+    const string socketPath = (directory / "PasswordManagerBench.sock").string();
+    std::filesystem::remove(fileName);
+    auto list = PasswordList(fileName, "benchmark");
+    for (std::size_t i = 0; i < size; ++i) {
+        list.addEntry(syntheticEntry(i));
+    }
+    LookupServer server(list, socketPath);
+    std::thread serving([&] { server.run(); });
+    std::mt19937 random(42);
+    vector<string> gets, websites;
+    for (int i = 0; i < 1000; ++i) {
+        auto n = random() % size;
+        gets.push_back("get\tcategory" + std::to_string(n % 16) + "\tname" + std::to_string(n));
+        websites.push_back("find\twebsite\twww.site" + std::to_string(n % 1000) + ".com");
+    }
+    for (string workload : {"get", "website"}) {
+        for (std::size_t connections : {1, 4, 16}) {
+            auto perConnection = workload == "get" ? 20'000 / connections : 400 / connections;
+            auto report = LookupClient::loadTest(socketPath, workload == "get" ? gets : websites, connections,
+                                                 perConnection);
+            Result result{"lookup_daemon", {{"entries", static_cast<double>(size)}, {"workload", workload},
+                                            {"connections", static_cast<double>(connections)}},
+                          std::move(report.latencies)};
+            result.counters.emplace_back("requests_per_s", report.requestsPerSecond());
+            result.counters.emplace_back("failed", static_cast<double>(report.failed));
+            results.push_back(std::move(result));
+        }
+    }
+    server.stop();
+    serving.join();
+    std::filesystem::remove(fileName);
+}
+#endif
+
+/**
+@brief The original byte by byte XOR, used as the reference output for the vectorized kernels.
+*/
+static string referenceXor(const string& data, const string& key) {
+    string result(data);
+    for (std::size_t i = 0; i < data.length(); ++i) {
+        result[i] ^= key[i % key.length()];
+    }
+    return result;
+}
+
+/**
+@brief Checks every supported XOR kernel against the reference output and measures its throughput.
+@return False if any kernel produced a different output than the reference.
+*/
+static bool benchXor() {
+    using Kernel = FileEncryptor::Kernel;
+    const std::pair<Kernel, const char*> kernels[] = {{Kernel::Scalar, "scalar"}, {Kernel::SSE2, "sse2"},
+                                                      {Kernel::AVX2, "avx2"}};
+    auto fe = FileEncryptor();
+    bool equivalent = true;
+    string data(8 << 20, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 131 + (i >> 7));
+    for (auto [kernel, name] : kernels) {
+        if (!FileEncryptor::kernelSupported(kernel)) continue;
+        for (std::size_t keySize : {1, 3, 15, 16, 17, 31, 32, 33, 64, 255, 256, 300}) {
+            string key(keySize, '\0');
+            for (std::size_t i = 0; i < keySize; ++i) key[i] = static_cast<char>('a' + i * 7 % 26);
+            for (std::size_t size : {0, 1, 15, 31, 32, 33, 100, 1000, 4099}) {
+                string block = data.substr(0, size);
+                fe.apply_xor(std::as_writable_bytes(std::span(block)), key, kernel);
+                if (block != referenceXor(data.substr(0, size), key)) {
+                    cerr << "xor " << name << " differs from reference (key " << keySize << ", size " << size
+                         << ")\n";
+                    equivalent = false;
+                }
+            }
+        }
+        if (!selected("apply_xor")) continue;
+        const string key = "benchmark-password";
+        Result result{"apply_xor", {{"kernel", name}}};
+        for (int i = 0; i < 30; ++i) {
+            result.samples.push_back(timed([&] { fe.apply_xor(std::as_writable_bytes(std::span(data)), key, kernel); }));
+        }
+        result.bytesPerSample = data.size();
+        results.push_back(std::move(result));
+    }
+    return equivalent;
+}
+
+/**
+@brief Checks every supported ChaCha20 kernel against the test vector of RFC 8439 and the scalar kernel, and
+measures its throughput.
+@return False if any kernel produced a wrong output.
+*/
+static bool benchChaCha20() {
+    using Kernel = FileEncryptor::Kernel;
+    const std::pair<Kernel, const char*> kernels[] = {{Kernel::Scalar, "scalar"}, {Kernel::SSE2, "sse2"},
+                                                      {Kernel::AVX2, "avx2"}};
+    // RFC 8439 section 2.4.2: key 00 01 .. 1f, nonce 00 00 00 00 00 00 00 4a 00 00 00 00, counter 1.
+    std::array<std::byte, 32> key;
+    for (std::size_t i = 0; i < key.size(); ++i) key[i] = static_cast<std::byte>(i);
+    std::array<std::byte, 12> nonce{};
+    nonce[7] = std::byte{0x4a};
+    const string plaintext = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the "
+                             "future, sunscreen would be it.";
+    const string expected = "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593d"
+                            "abcd62b3571639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16cc"
+                            "f806818ce91ab77937365af90bbf74a35be6b40b8eedf2785e42874d";
+    auto hex = [](std::span<const std::byte> bytes) {
+        string text;
+        for (auto byte : bytes) {
+            text += "0123456789abcdef"[std::to_integer<int>(byte) >> 4];
+            text += "0123456789abcdef"[std::to_integer<int>(byte) & 15];
+        }
+        return text;
+    };
+    bool equivalent = true;
+    string data(8 << 20, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 131 + (i >> 7));
+    string reference(data.size(), '\0');
+    ChaCha20(key, nonce, Kernel::Scalar).apply(std::as_bytes(std::span(data)),
+                                                std::as_writable_bytes(std::span(reference)), 0);
+    for (auto [kernel, name] : kernels) {
+        if (!FileEncryptor::kernelSupported(kernel)) continue;
+        ChaCha20 cipher(key, nonce, kernel);
+        string block(plaintext.size(), '\0');
+        cipher.apply(std::as_bytes(std::span(plaintext)), std::as_writable_bytes(std::span(block)),
+                     ChaCha20::blockSize);
+        if (hex(std::as_bytes(std::span(block))) != expected) {
+            cerr << "chacha20 " << name << " differs from RFC 8439\n";
+            equivalent = false;
+        }
+        for (std::size_t offset : {0, 1, 63, 64, 65, 511, 4096}) {
+            for (std::size_t size : {0, 1, 63, 64, 65, 255, 256, 257, 511, 512, 513, 5000}) {
+                block.assign(size, '\0');
+                cipher.apply(std::as_bytes(std::span(data).subspan(offset, size)),
+                             std::as_writable_bytes(std::span(block)), offset);
+                if (block != reference.substr(offset, size)) {
+                    cerr << "chacha20 " << name << " differs from scalar (offset " << offset << ", size " << size
+                         << ")\n";
+                    equivalent = false;
+                }
+            }
+        }
+        if (!selected("chacha20")) continue;
+        block.resize(data.size());
+        Result result{"chacha20", {{"kernel", name}}};
+        for (int i = 0; i < 30; ++i) {
+            result.samples.push_back(timed([&] {
+                cipher.apply(std::as_bytes(std::span(data)), std::as_writable_bytes(std::span(block)), 0);
+            }));
+        }
+        result.bytesPerSample = data.size();
+        results.push_back(std::move(result));
+    }
+    return equivalent;
+}
+
+/**
+@brief The password generation algorithm of UI::generatePassword, which can only be run interactively.
+*/
+static string referenceGeneratePassword(int number, const vector<string>& sets) {
+    string password;
+    std::random_device rd;
+    std::default_random_engine defEngine(rd());
+    for (int i = 0; i < number; ++i) {
+        string set = sets[std::uniform_int_distribution<int>(0, sets.size() - 1)(defEngine)];
+        password += set.at(std::uniform_int_distribution<int>(0, set.size() - 1)(defEngine));
+    }
+    return password;
+}
+
+/**
+@brief Compares generating passwords one by one the way UI::generatePassword used to with PasswordGenerator, one
+by one and in batches as the rotate command of BatchRunner does.
+*/
+static void benchGeneratePassword() {
+    if (!selected("generate_password")) return;
+    const vector<string> sets = {"abcdefghijklmnopqrstuvwxyz", "0123456789", "ABCDEFGHIJKLMNOPQRSTUVWXYZ", "!@#$%&"};
+    constexpr std::size_t length = 16;
+    constexpr std::size_t batch = 1000;
+    PasswordGenerator generator;
+    std::size_t checksum = 0;
+    for (auto [name, passwords] : {std::pair{"reference", std::size_t(1)}, std::pair{"generator", std::size_t(1)},
+                                   std::pair{"generator_batch", batch}}) {
+        Result result{"generate_password", {{"length", static_cast<double>(length)}, {"implementation", name},
+                                            {"passwords", static_cast<double>(passwords)}}};
+        string out;
+        for (int i = 0; i < 10'000 / static_cast<int>(std::min<std::size_t>(passwords, 100)); ++i) {
+            result.samples.push_back(timed([&] {
+                if (std::string_view(name) == "reference") {
+                    checksum += referenceGeneratePassword(length, sets).size();
+                } else {
+                    out.clear();
+                    generator.generate(length, passwords, out);
+                    checksum += out.size();
+                }
+            }));
+        }
+        auto sorted = result.samples;
+        std::ranges::sort(sorted);
+        result.counters.emplace_back("passwords_per_second", passwords * 1e9 / sorted[sorted.size() / 2]);
+        result.bytesPerSample = length * passwords;
+        results.push_back(std::move(result));
+    }
+    if (checksum == 0) cerr << "generate_password: nothing was generated\n";
+}
+
+/**
+@brief Quotes and escapes a string for use in JSON.
+*/
+static string jsonString(std::string_view text) {
+    string result;
+    EntryWriter::appendJson(result, text);
+    return result;
+}
+
+/**
+@brief Formats a number for JSON, which has no representation for infinity or NaN.
+*/
+static string number(double value) {
+    if (!std::isfinite(value)) return "null";
+    std::ostringstream stream;
+    stream.precision(15);
+    stream << value;
+    return stream.str();
+}
+
+/**
+@brief Retrieves a percentile of sorted samples using the nearest rank method.
+*/
+static double percentile(const vector<double>& sorted, double rank) {
+    auto index = static_cast<std::size_t>(std::ceil(rank / 100 * sorted.size()));
+    return sorted[std::clamp<std::size_t>(index, 1, sorted.size()) - 1];
+}
+
+/**
+@brief Formats the results as JSON. Durations are in nanoseconds.
+*/
+static string toJson() {
+    std::ostringstream json;
+    json << "{\n  \"suite\": \"PasswordManagerBench\",\n  \"unit\": \"ns\",\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        json << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(result.name) << ", \"params\": {";
+        for (std::size_t p = 0; p < result.params.size(); ++p) {
+            const auto& [key, value] = result.params[p];
+            json << (p == 0 ? "" : ", ") << jsonString(key) << ": ";
+            if (auto text = std::get_if<string>(&value)) json << jsonString(*text);
+            else json << number(std::get<double>(value));
+        }
+        json << "}";
+        if (!result.samples.empty()) {
+            auto sorted = result.samples;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0;
+            for (auto sample : sorted) sum += sample;
+            auto mean = sum / sorted.size();
+            json << ", \"samples\": " << sorted.size() << ", \"mean\": " << number(mean)
+                 << ", \"min\": " << number(sorted.front()) << ", \"p50\": " << number(percentile(sorted, 50))
+                 << ", \"p90\": " << number(percentile(sorted, 90)) << ", \"p99\": " << number(percentile(sorted, 99))
+                 << ", \"max\": " << number(sorted.back());
+            if (result.bytesPerSample != 0) {
+                json << ", \"bytes_per_second\": " << number(result.bytesPerSample / (percentile(sorted, 50) / 1e9));
+            }
+        }
+        if (!result.counters.empty()) {
+            json << ", \"counters\": {";
+            for (std::size_t c = 0; c < result.counters.size(); ++c) {
+                json << (c == 0 ? "" : ", ") << jsonString(result.counters[c].first) << ": "
+                     << number(result.counters[c].second);
+            }
+            json << "}";
+        }
+        json << "}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+/**
+@brief Runs the benchmark suite and prints the results as JSON.
+Usage: PasswordManagerBench [--filter=<text>] [--output=<file>] [entries...]
+ where entries are the vault sizes to benchmark (10000, 100000 and 1000000 by default).
+@return 0 if the benchmarks ran, 1 if implementations disagreed or snapshots were inconsistent, 2 if an argument is
+ not understood, in which case the usage is printed.
+*/
+int main(int argc, char* argv[]) {
+    vector<std::size_t> sizes;
+    string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument.starts_with("--filter=")) {
+            filter = argument.substr(9);
+        } else if (argument.starts_with("--output=")) {
+            output = argument.substr(9);
+        } else {
+            std::size_t size = 0;
+            auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), size);
+            if (error != std::errc() || end != argument.data() + argument.size() || size == 0) {
+                cerr << "Usage: " << argv[0] << " [--filter=<text>] [--output=<file>] [entries...]\n";
+                return 2;
+            }
+            sizes.push_back(size);
+        }
+    }
+    if (sizes.empty()) sizes = {10'000, 100'000, 1'000'000};
+
+    const string password = "benchmark";
+    const string fileName = (std::filesystem::temp_directory_path() / "PasswordManagerBench.txt").string();
+    for (auto size : sizes) {
+        cerr << "benchmarking " << size << " entries\n";
+        generateVault(fileName, password, size);
+        benchVault(fileName, password, size);
+        benchBatch(fileName, password, size);
+        benchExchange(fileName, password, size);
+        benchFormats(fileName, password, size);
+        benchStorage(fileName, password, size);
+        benchCompression(fileName, password, size);
+        benchEditSave(fileName, password, size);
+        if (size == sizes.back()) {
+            benchParallelLoad(fileName, password, size);
+            benchMemory(fileName, password, size);
+        }
+    }
+    std::filesystem::remove(fileName);
+    std::filesystem::remove(fileName + ".journal");
+    benchSearch(sizes.back());
+    benchSnapshots(sizes.back());
+#ifdef __linux__
+    benchDaemon(sizes.back());
+#endif
+    benchVaults(10'000);
+    bool equivalent = benchSnapshotStress();
+    equivalent = benchXor() && equivalent;
+    equivalent = benchChaCha20() && equivalent;
+    benchGeneratePassword();
+
+    if (output.empty()) {
+        cout << toJson();
+    } else {
+        std::ofstream(output) << toJson();
+    }
+    return equivalent ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+#include "BinaryVault.h"
+#include <algorithm>
+#include <memory>
+#include "DecryptionException.h"
+#include "FileEncryptor.h"
+#include "Lz4.h"
+#include "Stats.h"
+
+namespace {
+    template <typename T>
+    void putInt(string& out, T value) {
+        for (std::size_t i = 0; i < sizeof(T); ++i) out += static_cast<char>(value >> (8 * i) & 0xFF);
+    }
+
+    template <typename T>
+    T getInt(const char* in) {
+        T value = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            value |= static_cast<T>(static_cast<unsigned char>(in[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+    @brief Decrypts a part of the data into a buffer.
+    @param stream The position of the keystream the part is encrypted at.
+    @return The decrypted bytes, valid until the buffer is next used.
+    */
+    std::string_view decrypt(std::span<const std::byte> data, const CipherEngine& engine, std::size_t offset,
+                             std::uint64_t stream, std::size_t size, std::unique_ptr<char[]>& buffer,
+                             std::size_t& capacity) {
+        if (size > capacity) {
+            buffer = std::make_unique_for_overwrite<char[]>(size);
+            capacity = size;
+        }
+        FileEncryptor().decrypt(data.subspan(offset, size), std::as_writable_bytes(std::span(buffer.get(), size)),
+                                engine, stream);
+        return {buffer.get(), size};
+    }
+
+    /**
+    @brief Bounds-checked reading of a decrypted directory.
+    */
+    class DirectoryParser {
+        std::string_view rest;
+    public:
+        explicit DirectoryParser(std::string_view directory) : rest(directory) {}
+
+        std::string_view take(std::size_t size) {
+            if (size > rest.size()) throw DecryptionException();
+            auto taken = rest.substr(0, size);
+            rest.remove_prefix(size);
+            return taken;
+        }
+
+        template <typename T>
+        T get() {
+            return getInt<T>(take(sizeof(T)).data());
+        }
+
+        bool done() const {
+            return rest.empty();
+        }
+    };
+}
+
+std::uint64_t BinaryVault::checksum(std::span<const std::byte> data) {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto bytes = reinterpret_cast<const char*>(data.data());
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        hash = (hash ^ getInt<std::uint64_t>(bytes + i)) * 1099511628211ull;
+    }
+    for (; i < data.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+BinaryVault::Writer::Writer(string &out, Compression compression, std::uint64_t streamStart)
+        : out(out), start(out.size()), compression(compression) {
+    layout.streamEnd = streamStart;
+    out.append(locatorSize, '\0');
+}
+
+void BinaryVault::Writer::closeBlock() {
+    if (!blockOpen) return;
+    auto& block = layout.blocks.back();
+    auto recordsStart = out.size();
+    if (compression == Compression::Lz4) Lz4::compress(records, out);
+    // Records that do not shrink are stored as they are, which a stored size equal to the plain size tells.
+    if (compression == Compression::None || out.size() - recordsStart >= records.size()) {
+        out.resize(recordsStart);
+        out += records;
+    }
+    block.recordsSize = out.size() - recordsStart;
+    block.size = block.recordsSize + passwords.size();
+    out += passwords;
+    records.clear();
+    passwords.clear();
+    blockOpen = false;
+}
+
+void BinaryVault::Writer::closeSegment() {
+    closeBlock();
+    if (!segmentOpen) return;
+    auto& segment = layout.segments.back();
+    segment.size = out.size() - start - segment.offset;
+    segment.stream = layout.streamEnd;
+    layout.streamEnd += segment.size;
+    for (auto i = segment.firstBlock; i < segment.firstBlock + segment.blockCount; ++i) {
+        auto& block = layout.blocks[i];
+        block.stream = segment.stream + (block.offset - segment.offset);
+    }
+    encoded.push_back(layout.segments.size() - 1);
+    segmentOpen = false;
+}
+
+void BinaryVault::Writer::beginCategory(std::string_view name) {
+    closeSegment();
+    layout.segments.push_back({string(name), out.size() - start, 0, 0, 0,
+                               static_cast<std::uint32_t>(layout.blocks.size()), 0});
+    segmentOpen = true;
+}
+
+void BinaryVault::Writer::add(const EntryRef &entry) {
+    if (!blockOpen || layout.blocks.back().size >= blockSize) {
+        closeBlock();
+        layout.blocks.push_back({static_cast<std::uint32_t>(layout.segments.size() - 1), 0, out.size() - start,
+                                 0, 0, 0, 0});
+        ++layout.segments.back().blockCount;
+        blockOpen = true;
+    }
+    for (auto field : {entry.getName(), entry.getLogin(), entry.getWebsite()}) {
+        putInt<std::uint16_t>(records, field.size());
+        records += field;
+    }
+    auto passwordStart = passwords.size();
+    entry.appendPassword(passwords);
+    putInt<std::uint16_t>(records, passwords.size() - passwordStart);
+    // Until the block is closed its sizes are those of the uncompressed records.
+    auto& block = layout.blocks.back();
+    ++block.count;
+    block.plainRecordsSize = records.size();
+    block.size = records.size() + passwords.size();
+}
+
+void BinaryVault::Writer::copyCategory(const Segment &segment, std::span<const Block> blocks,
+                                       std::span<const std::byte> encrypted) {
+    closeSegment();
+    auto copy = segment;
+    copy.offset = out.size() - start;
+    copy.firstBlock = static_cast<std::uint32_t>(layout.blocks.size());
+    out.append(reinterpret_cast<const char*>(encrypted.data()), encrypted.size());
+    for (auto block : blocks) {
+        block.category = static_cast<std::uint32_t>(layout.segments.size());
+        block.offset = block.offset - segment.offset + copy.offset;
+        layout.blocks.push_back(block);
+    }
+    layout.segments.push_back(std::move(copy));
+}
+
+BinaryVault::Layout
+BinaryVault::Writer::finish(const std::function<void(std::span<std::byte>, std::uint64_t)> &encrypt) {
+    closeSegment();
+    auto bytes = [&](std::uint64_t offset, std::uint64_t size) {
+        return std::as_writable_bytes(std::span(out)).subspan(start + offset, size);
+    };
+    for (auto index : encoded) {
+        auto& segment = layout.segments[index];
+        encrypt(bytes(segment.offset, segment.size), segment.stream);
+        segment.checksum = checksum(bytes(segment.offset, segment.size));
+    }
+    std::uint64_t directoryOffset = out.size() - start;
+    putInt<std::uint32_t>(out, layout.segments.size());
+    for (const auto& segment : layout.segments) {
+        putInt<std::uint32_t>(out, segment.category.size());
+        out += segment.category;
+        putInt(out, segment.offset);
+        putInt(out, segment.stream);
+        putInt(out, segment.size);
+        putInt(out, segment.checksum);
+        putInt(out, segment.blockCount);
+        for (auto i = segment.firstBlock; i < segment.firstBlock + segment.blockCount; ++i) {
+            const auto& block = layout.blocks[i];
+            putInt(out, block.count);
+            putInt(out, block.size);
+            putInt(out, block.recordsSize);
+            putInt(out, block.plainRecordsSize);
+        }
+    }
+    auto directory = bytes(directoryOffset, out.size() - start - directoryOffset);
+    auto directoryStream = layout.streamEnd;
+    encrypt(directory, directoryStream);
+    layout.streamEnd += directory.size();
+    string locator;
+    putInt(locator, directoryOffset);
+    putInt(locator, directoryStream);
+    putInt(locator, layout.streamEnd);
+    putInt(locator, checksum(directory));
+    out.replace(start, locatorSize, locator);
+    return std::move(layout);
+}
+
+BinaryVault::Reader::Reader(std::span<const std::byte> data, const CipherEngine &engine, const VaultHeader &header)
+        : data(data), engine(engine), separatePasswords(header.version >= 4), compression(header.compression) {
+    layoutData.header = header;
+    if (header.version >= VaultHeader::segmentedVersion) {
+        readSegmentedDirectory();
+    } else {
+        readDirectory(header);
+    }
+}
+
+void BinaryVault::Reader::checkBlock(const Block &block, std::uint64_t limit) const {
+    if (block.size > limit - block.offset || block.recordsSize > block.size) throw DecryptionException();
+    // A block is only compressed if that makes it smaller, and no codec expands data more than 255 times.
+    if (block.plainRecordsSize != block.recordsSize &&
+        (compression == Compression::None || block.plainRecordsSize < block.recordsSize ||
+         block.plainRecordsSize / 255 > block.recordsSize)) {
+        throw DecryptionException();
+    }
+}
+
+void BinaryVault::Reader::readDirectory(const VaultHeader &header) {
+    if (data.size() < prefixSize) throw DecryptionException();
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity = 0;
+    auto prefix = decrypt(data, engine, 0, 0, prefixSize, buffer, capacity);
+    auto directoryOffset = getInt<std::uint64_t>(prefix.data());
+    auto categoryCount = getInt<std::uint32_t>(prefix.data() + 8);
+    auto blockCount = getInt<std::uint32_t>(prefix.data() + 12);
+    const std::size_t blockEntrySize = header.version >= 5 ? 4 + 4 + 8 + 8 + 8 + 8
+                                       : separatePasswords ? 4 + 4 + 8 + 8 + 8 : 4 + 4 + 8 + 8;
+    if (directoryOffset < prefixSize || directoryOffset > data.size() ||
+        blockCount > (data.size() - directoryOffset) / blockEntrySize) {
+        throw DecryptionException();
+    }
+    auto directory = decrypt(data, engine, directoryOffset, directoryOffset, data.size() - directoryOffset,
+                             buffer, capacity);
+
+    // The blocks have to cover the records exactly, in order, so any range of them is a contiguous run of records.
+    auto& blockList = layoutData.blocks;
+    blockList.reserve(blockCount);
+    std::uint64_t expectedOffset = prefixSize;
+    for (std::size_t i = 0; i < blockCount; ++i) {
+        auto entry = directory.data() + i * blockEntrySize;
+        Block block{getInt<std::uint32_t>(entry), getInt<std::uint32_t>(entry + 4), getInt<std::uint64_t>(entry + 8),
+                    0, getInt<std::uint64_t>(entry + 16), 0, 0};
+        block.stream = block.offset;
+        block.recordsSize = separatePasswords ? getInt<std::uint64_t>(entry + 24) : block.size;
+        block.plainRecordsSize = header.version >= 5 ? getInt<std::uint64_t>(entry + 32) : block.recordsSize;
+        if (block.category >= categoryCount || block.offset != expectedOffset) throw DecryptionException();
+        checkBlock(block, directoryOffset);
+        expectedOffset += block.size;
+        blockList.push_back(block);
+    }
+    if (expectedOffset != directoryOffset) throw DecryptionException();
+
+    auto names = directory.substr(blockCount * blockEntrySize);
+    categoryNames.reserve(std::min<std::size_t>(categoryCount, names.size() / 4));
+    for (std::size_t i = 0; i < categoryCount; ++i) {
+        if (names.size() < 4) throw DecryptionException();
+        auto size = getInt<std::uint32_t>(names.data());
+        if (size > names.size() - 4) throw DecryptionException();
+        categoryNames.emplace_back(names.substr(4, size));
+        names.remove_prefix(4 + size);
+    }
+    if (!names.empty()) throw DecryptionException();
+    layoutData.streamEnd = data.size();
+}
+
+void BinaryVault::Reader::readSegmentedDirectory() {
+    if (data.size() < locatorSize) throw DecryptionException();
+    auto locator = reinterpret_cast<const char*>(data.data());
+    auto directoryOffset = getInt<std::uint64_t>(locator);
+    auto directoryStream = getInt<std::uint64_t>(locator + 8);
+    auto streamEnd = getInt<std::uint64_t>(locator + 16);
+    auto directorySize = data.size() - directoryOffset;
+    if (directoryOffset < locatorSize || directoryOffset > data.size() || streamEnd > streamLimit ||
+        directoryStream > streamEnd || directorySize > streamEnd - directoryStream) {
+        throw DecryptionException();
+    }
+    auto encryptedDirectory = data.subspan(directoryOffset);
+    if (checksum(encryptedDirectory) != getInt<std::uint64_t>(locator + 24)) throw DecryptionException();
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity = 0;
+    DirectoryParser directory(decrypt(data, engine, directoryOffset, directoryStream, directorySize, buffer, capacity));
+
+    // The segments cover the records exactly, in order, as do the blocks of every segment.
+    auto segmentCount = directory.get<std::uint32_t>();
+    std::uint64_t expectedOffset = locatorSize;
+    for (std::uint32_t i = 0; i < segmentCount; ++i) {
+        Segment segment;
+        segment.category = directory.take(directory.get<std::uint32_t>());
+        segment.offset = directory.get<std::uint64_t>();
+        segment.stream = directory.get<std::uint64_t>();
+        segment.size = directory.get<std::uint64_t>();
+        segment.checksum = directory.get<std::uint64_t>();
+        segment.blockCount = directory.get<std::uint32_t>();
+        segment.firstBlock = static_cast<std::uint32_t>(layoutData.blocks.size());
+        if (segment.offset != expectedOffset || segment.size > directoryOffset - segment.offset ||
+            segment.stream > streamEnd || segment.size > streamEnd - segment.stream) {
+            throw DecryptionException();
+        }
+        auto segmentEnd = segment.offset + segment.size;
+        for (std::uint32_t b = 0; b < segment.blockCount; ++b) {
+            Block block{i, directory.get<std::uint32_t>(), expectedOffset,
+                        segment.stream + (expectedOffset - segment.offset), directory.get<std::uint64_t>(), 0, 0};
+            block.recordsSize = directory.get<std::uint64_t>();
+            block.plainRecordsSize = directory.get<std::uint64_t>();
+            checkBlock(block, segmentEnd);
+            expectedOffset += block.size;
+            layoutData.blocks.push_back(block);
+        }
+        if (expectedOffset != segmentEnd) throw DecryptionException();
+        categoryNames.push_back(segment.category);
+        layoutData.segments.push_back(std::move(segment));
+    }
+    if (expectedOffset != directoryOffset || !directory.done()) throw DecryptionException();
+    layoutData.streamEnd = streamEnd;
+}
+
+bool BinaryVault::Reader::canSeal() const {
+    return separatePasswords;
+}
+
+const vector<string> &BinaryVault::Reader::categories() const {
+    return categoryNames;
+}
+
+const vector<BinaryVault::Block> &BinaryVault::Reader::blocks() const {
+    return layoutData.blocks;
+}
+
+const BinaryVault::Layout &BinaryVault::Reader::layout() const {
+    return layoutData;
+}
+
+void BinaryVault::Reader::verify(std::size_t segment) const {
+    const auto& described = layoutData.segments[segment];
+    if (checksum(data.subspan(described.offset, described.size)) != described.checksum) {
+        throw DecryptionException();
+    }
+}
+
+void BinaryVault::Reader::read(std::size_t first, std::size_t last, EntryStore &part, bool seal) const {
+    STATS_TIMER(timer, "BinaryVault::Reader::read");
+    // Blocks are decrypted one at a time into a buffer that stays in the cache while they are parsed. Sealed
+    // passwords are copied straight from the data, so only the records are decrypted.
+    std::unique_ptr<char[]> buffer, plainBuffer;
+    std::size_t capacity = 0, plainCapacity = 0;
+    string sealedPassword;
+    for (auto i = first; i < last; ++i) {
+        const auto& block = layoutData.blocks[i];
+        STATS_BYTES(timer, block.size);
+        auto decrypted = decrypt(data, engine, block.offset, block.stream, seal ? block.recordsSize : block.size,
+                                 buffer, capacity);
+        auto records = decrypted.substr(0, block.recordsSize);
+        auto passwords = decrypted.substr(records.size());
+        if (block.plainRecordsSize != block.recordsSize) {
+            if (block.plainRecordsSize > plainCapacity) {
+                plainBuffer = std::make_unique_for_overwrite<char[]>(block.plainRecordsSize);
+                plainCapacity = block.plainRecordsSize;
+            }
+            std::span plain(plainBuffer.get(), block.plainRecordsSize);
+            if (!Lz4::decompress(records, plain)) throw DecryptionException();
+            records = std::string_view(plain.data(), plain.size());
+        }
+        auto passwordsLeft = block.size - block.recordsSize;
+        auto take = [&](std::size_t size) {
+            if (size > records.size()) throw DecryptionException();
+            auto taken = records.substr(0, size);
+            records.remove_prefix(size);
+            return taken;
+        };
+        auto takeField = [&] { return take(getInt<std::uint16_t>(take(2).data())); };
+        auto category = part.intern(categoryNames[block.category]);
+        for (std::uint32_t entry = 0; entry < block.count; ++entry) {
+            if (!separatePasswords) {
+                auto name = takeField();
+                auto password = takeField();
+                auto login = takeField();
+                part.add(category, name, password, login, takeField());
+                continue;
+            }
+            auto name = takeField();
+            auto login = takeField();
+            auto website = takeField();
+            std::size_t size = getInt<std::uint16_t>(take(2).data());
+            if (size > passwordsLeft) throw DecryptionException();
+            auto position = block.size - passwordsLeft;
+            std::string_view password;
+            if (seal) {
+                sealedPassword.clear();
+                PasswordSealer::appendSealed(sealedPassword, block.stream + position, std::string_view(
+                        reinterpret_cast<const char*>(data.data()) + block.offset + position, size));
+                password = sealedPassword;
+            } else {
+                password = passwords.substr(position - block.recordsSize, size);
+            }
+            passwordsLeft -= size;
+            part.add(category, name, password, login, website);
+        }
+        if (!records.empty() || (separatePasswords && passwordsLeft != 0)) throw DecryptionException();
+    }
+}
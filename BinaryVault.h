@@ -0,0 +1,301 @@
+#ifndef PASSWORDMANAGER_BINARYVAULT_H
+#define PASSWORDMANAGER_BINARYVAULT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CipherEngine.h"
+#include "EntryStore.h"
+#include "VaultHeader.h"
+
+using std::string, std::vector;
+
+/**
+* @brief The binary layout of the data of a vault, used since version 3 of the vault header.
+* All integers are little-endian. The data starts with a prefix of prefixSize bytes: the offset of the directory
+* (8 bytes), the number of categories (4 bytes) and the number of blocks (4 bytes). The blocks of records follow.
+* Every block holds a record for each of its entries: the name, login and website, each as a 2-byte length and the
+* bytes of the field, and the 2-byte length of the password. The passwords of the block follow its records.
+* The directory ends the data: for every block its category, its number of entries (4 bytes each), its offset, its
+* size, the size of its records and the size of its records once decompressed (8 bytes each), then every category
+* name as a 4-byte length and the bytes of the name.
+* The records of a block are compressed with the codec named in the vault header when that makes them smaller, and
+* stored as they are otherwise, which their two sizes being equal tells. The passwords are never compressed, so
+* they can still be read without touching the rest of the block.
+* The entries of a category are split into consecutive blocks of about blockSize bytes, so a reader can jump
+* straight to the records of a category, and split the records into pieces decoded on different threads. Keeping
+* the passwords apart lets a reader load the other fields and leave the passwords encrypted.
+* Version 3 stored the password of every entry in its record, between the name and the login, and had no record
+* size in the directory. Version 4 did not compress the records and had no decompressed size in the directory.
+* Fields may hold any bytes, including the commas and line breaks the text format of older versions could not store.
+*
+* Since version 6 every category is a segment of its own, encrypted apart from the others, so a save only encodes
+* the categories that changed and copies the encrypted bytes of the others. The data starts with a locator of
+* locatorSize bytes that is not encrypted: the offset of the directory, the position of the keystream it is
+* encrypted at, the end of the keystream used by the file and the checksum of the encrypted directory (8 bytes each).
+* The segments follow, in the order of their categories, each made of the blocks of its category. The directory
+* ends the data: the number of segments (4 bytes), then for every segment its category name as a 4-byte length and
+* the bytes of the name, its offset, the position of the keystream it is encrypted at, its size and the checksum of
+* its encrypted bytes (8 bytes each) and its number of blocks (4 bytes), then for every block its number of entries
+* (4 bytes), its size, the size of its records and the size of its records once decompressed (8 bytes each).
+* A segment that is encoded again is encrypted at the end of the keystream used so far rather than where it was, so
+* all versions of a file share a key without any keystream being used twice. The file is given a new key once the
+* keystream reaches streamLimit; the positions past it are left to PasswordSealer.
+*/
+namespace BinaryVault {
+    /**
+     * Size of the prefix holding the location of the directory.
+     */
+    constexpr std::size_t prefixSize = 8 + 4 + 4;
+    /**
+     * Size of the locator starting the data since version 6.
+     */
+    constexpr std::size_t locatorSize = 8 + 8 + 8 + 8;
+    /**
+     * Size of a block above which the next entry starts a new block.
+     */
+    constexpr std::size_t blockSize = 1 << 16;
+    /**
+     * Position of the keystream the segments of a file stay below. The sealer of a file loaded since version 6 seals
+     * passwords from there on, and ChaCha20 can go as far again before its block counter runs out.
+     */
+    constexpr std::uint64_t streamLimit = std::uint64_t{1} << 37;
+
+    /**
+    * @brief A run of records of a single category.
+    */
+    struct Block {
+        std::uint32_t category;
+        std::uint32_t count;
+        /**
+         * Offset of the first record within the data.
+         */
+        std::uint64_t offset;
+        /**
+         * Position of the keystream the first record is encrypted at. Equals the offset before version 6.
+         */
+        std::uint64_t stream;
+        std::uint64_t size;
+        /**
+         * Size of the records at the start of the block, which the passwords follow. Equals the size of the block
+         * in version 3.
+         */
+        std::uint64_t recordsSize;
+        /**
+         * Size of the records once decompressed. Equals recordsSize if they are not compressed.
+         */
+        std::uint64_t plainRecordsSize;
+    };
+
+    /**
+    * @brief The category stored in a segment of the data, since version 6.
+    */
+    struct Segment {
+        string category;
+        /**
+         * Offset of the segment within the data.
+         */
+        std::uint64_t offset;
+        /**
+         * Position of the keystream the segment is encrypted at.
+         */
+        std::uint64_t stream;
+        std::uint64_t size;
+        /**
+         * Checksum of the encrypted bytes of the segment.
+         */
+        std::uint64_t checksum;
+        /**
+         * Index of the first block of the segment, and number of its blocks.
+         */
+        std::uint32_t firstBlock, blockCount;
+    };
+
+    /**
+    * @brief Where the categories of data in the segmented layout are stored, and the header they are encrypted under.
+    */
+    struct Layout {
+        VaultHeader header;
+        /**
+         * The segments in the order of the data.
+         */
+        vector<Segment> segments;
+        /**
+         * The blocks of all segments in the order of the data, their category being the index of their segment.
+         */
+        vector<Block> blocks;
+        /**
+         * The first position of the keystream not used by the data.
+         */
+        std::uint64_t streamEnd = 0;
+    };
+
+    /**
+    @brief Computes the checksum of encrypted bytes: FNV-1a over 8-byte words rather than single bytes, so verifying
+     a file does not slow down unlocking it. It detects damage, not tampering.
+    @param data The bytes to checksum.
+    @return The checksum.
+    */
+    std::uint64_t checksum(std::span<const std::byte> data);
+
+    /**
+    * @brief Class appending the segmented layout of a list of entries to a string.
+    * Categories are either encoded from their entries, or copied as the encrypted segment of a previous version of
+    * the file encrypted under the same key. finish() encrypts the segments that were encoded, at positions of the
+    * keystream past the ones used before.
+    */
+    class Writer {
+        string& out;
+        /**
+         * Position of the data within the output.
+         */
+        std::size_t start;
+        Compression compression;
+        /**
+         * The segments and blocks written so far. The end of its keystream is the position the next encoded segment
+         * is encrypted at.
+         */
+        Layout layout;
+        /**
+         * Indexes of the segments that were encoded rather than copied, and still have to be encrypted.
+         */
+        vector<std::size_t> encoded;
+        /**
+         * The records and the passwords of the last block, appended when the block is closed.
+         */
+        string records, passwords;
+        /**
+         * Whether the last block, and the last segment, are still being added to.
+         */
+        bool blockOpen = false, segmentOpen = false;
+        /**
+        @brief Appends the records, compressed if that makes them smaller, and the passwords of the last block,
+         closing it.
+        */
+        void closeBlock();
+        /**
+        @brief Closes the last segment if it is being encoded, choosing the position of the keystream it is
+         encrypted at.
+        */
+        void closeSegment();
+    public:
+        /**
+        @brief Constructs a Writer for the current version, appending a placeholder for the locator to the output.
+        @param out The string to append the data to.
+        @param compression The codec the records are compressed with.
+        @param streamStart The first position of the keystream that was never used under the key of the data.
+        */
+        Writer(string& out, Compression compression, std::uint64_t streamStart = 0);
+        /**
+        @brief Starts encoding a category. The entries added next belong to it.
+        @param name The name of the category.
+        */
+        void beginCategory(std::string_view name);
+        /**
+        @brief Appends an entry to the current category.
+        @param entry The entry to append. Its fields must not be longer than EntryStore::maxFieldSize.
+        */
+        void add(const EntryRef& entry);
+        /**
+        @brief Appends a category as the unchanged segment of a previous version of the data.
+        @param segment The segment, as described by the layout of the previous version.
+        @param blocks The blocks of the segment, as described by the layout of the previous version.
+        @param encrypted The encrypted bytes of the segment. Their checksum must match the segment.
+        */
+        void copyCategory(const Segment& segment, std::span<const Block> blocks,
+                          std::span<const std::byte> encrypted);
+        /**
+        @brief Encrypts the encoded segments, appends the directory and fills in the locator. Nothing can be added
+         afterwards.
+        @param encrypt Encrypts bytes of the output in place at the given position of the keystream.
+        @return The layout of the data, with a default header.
+        */
+        Layout finish(const std::function<void(std::span<std::byte>, std::uint64_t)>& encrypt);
+    };
+
+    /**
+    * @brief Class reading encrypted data in the binary layout.
+    * The constructor only decrypts the prefix and the directory; the records are decrypted and parsed block by block
+    * when asked for, so any part of the data can be read without touching the rest.
+    */
+    class Reader {
+        std::span<const std::byte> data;
+        const CipherEngine& engine;
+        /**
+         * Whether the passwords are kept apart from the records, as they are since version 4.
+         */
+        bool separatePasswords;
+        Compression compression;
+        vector<string> categoryNames;
+        /**
+         * The blocks, and since version 6 the segments holding them.
+         */
+        Layout layoutData;
+        /**
+        @brief Reads the prefix and the directory of data in the layout of versions 3 to 5.
+        */
+        void readDirectory(const VaultHeader& header);
+        /**
+        @brief Reads the locator and the directory of data in the segmented layout.
+        */
+        void readSegmentedDirectory();
+        /**
+        @brief Checks the sizes of a block read from a directory.
+        @param limit The offset the block has to end before.
+        */
+        void checkBlock(const Block& block, std::uint64_t limit) const;
+    public:
+        /**
+        @brief Constructs a Reader, reading the directory of the data.
+        @param data The encrypted data. Must stay valid for the lifetime of the reader.
+        @param engine The engine the data is encrypted with, the data starting at offset 0 of the stream.
+        @param header The vault header of the data, of version 3 or later.
+        @throws DecryptionException If the prefix or the directory is damaged.
+        */
+        Reader(std::span<const std::byte> data, const CipherEngine& engine, const VaultHeader& header);
+        /**
+        @brief Checks if the passwords can be left encrypted when reading, which requires version 4.
+        @return True if read() can seal the passwords, false otherwise.
+        */
+        bool canSeal() const;
+        /**
+        @brief Retrieves the names of the categories, including the ones without entries.
+        @return The names, indexed by the category of the blocks.
+        */
+        const vector<string>& categories() const;
+        /**
+        @brief Retrieves the blocks in the order of their records.
+        @return The blocks.
+        */
+        const vector<Block>& blocks() const;
+        /**
+        @brief Retrieves where the categories are stored, for data in the segmented layout.
+        @return The layout, without segments before version 6.
+        */
+        const Layout& layout() const;
+        /**
+        @brief Checks the encrypted bytes of a segment against its checksum.
+        @param segment The index of the segment.
+        @throws DecryptionException If the segment is damaged.
+        */
+        void verify(std::size_t segment) const;
+        /**
+        @brief Decrypts, decompresses and parses a range of blocks, adding their entries to a store in file order.
+        Ranges that do not overlap can be read on different threads into different stores.
+        @param first The index of the first block to read.
+        @param last The index past the last block to read.
+        @param part The store receiving the entries. It must not seal passwords itself.
+        @param seal Whether to store the passwords in the form of PasswordSealer::appendSealed without decrypting
+         them, for a store whose sealer uses the engine of the data. Requires canSeal().
+        @throws DecryptionException If a record is damaged.
+        */
+        void read(std::size_t first, std::size_t last, EntryStore& part, bool seal = false) const;
+    };
+}
+
+
+#endif //PASSWORDMANAGER_BINARYVAULT_H
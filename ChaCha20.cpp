@@ -0,0 +1,264 @@
+#include "ChaCha20.h"
+#include <algorithm>
+#include <bit>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PASSWORDMANAGER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using BlocksFunction = void (*)(const std::uint32_t* initial, std::uint32_t counter, const std::byte* source,
+                                    std::byte* destination, std::size_t blocks);
+
+    inline void quarterRound(std::uint32_t& a, std::uint32_t& b, std::uint32_t& c, std::uint32_t& d) {
+        a += b; d ^= a; d = std::rotl(d, 16);
+        c += d; b ^= c; b = std::rotl(b, 12);
+        a += b; d ^= a; d = std::rotl(d, 8);
+        c += d; b ^= c; b = std::rotl(b, 7);
+    }
+
+    /**
+    @brief Computes one block of keystream.
+    */
+    void keystreamBlock(const std::uint32_t* initial, std::uint32_t counter, std::byte* out) {
+        std::array<std::uint32_t, 16> x;
+        std::copy_n(initial, 16, x.begin());
+        x[12] = counter;
+        for (int round = 0; round < 10; ++round) {
+            quarterRound(x[0], x[4], x[8], x[12]);
+            quarterRound(x[1], x[5], x[9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[8], x[13]);
+            quarterRound(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) {
+            auto word = x[i] + (i == 12 ? counter : initial[i]);
+            for (int k = 0; k < 4; ++k) {
+                out[4 * i + k] = static_cast<std::byte>(word >> (8 * k));
+            }
+        }
+    }
+
+    /**
+    @brief XORs the data with the keystream of a partial block, starting at the given position within the block.
+    */
+    void applyPartial(const std::uint32_t* initial, std::uint32_t counter, std::size_t start,
+                      const std::byte* source, std::byte* destination, std::size_t size) {
+        std::array<std::byte, ChaCha20::blockSize> keystream;
+        keystreamBlock(initial, counter, keystream.data());
+        for (std::size_t i = 0; i < size; ++i) {
+            destination[i] = source[i] ^ keystream[start + i];
+        }
+    }
+
+    void blocksScalar(const std::uint32_t* initial, std::uint32_t counter, const std::byte* source,
+                      std::byte* destination, std::size_t blocks) {
+        for (std::size_t b = 0; b < blocks; ++b) {
+            auto offset = b * ChaCha20::blockSize;
+            applyPartial(initial, counter + b, 0, source + offset, destination + offset, ChaCha20::blockSize);
+        }
+    }
+
+#ifdef PASSWORDMANAGER_X86
+    // The vectorized kernels keep word i of several blocks in register i, one block per 32-bit lane, so every
+    // quarter round works on all the blocks at once. The words are transposed back into blocks at the end.
+
+    __attribute__((target("sse2")))
+    inline __m128i rotateSse2(__m128i x, int n) {
+        return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+    }
+
+    __attribute__((target("sse2")))
+    inline void quarterRoundSse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a);
+        // Rotating by 16 swaps the halves of every word.
+        d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xB1), 0xB1);
+        c = _mm_add_epi32(c, d); b = rotateSse2(_mm_xor_si128(b, c), 12);
+        a = _mm_add_epi32(a, b); d = rotateSse2(_mm_xor_si128(d, a), 8);
+        c = _mm_add_epi32(c, d); b = rotateSse2(_mm_xor_si128(b, c), 7);
+    }
+
+    __attribute__((target("sse2")))
+    void blocksSse2(const std::uint32_t* initial, std::uint32_t counter, const std::byte* source,
+                    std::byte* destination, std::size_t blocks) {
+        std::size_t b = 0;
+        for (; b + 4 <= blocks; b += 4) {
+            __m128i start[16];
+            __m128i x[16];
+            for (int i = 0; i < 16; ++i) {
+                start[i] = _mm_set1_epi32(static_cast<int>(initial[i]));
+            }
+            start[12] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter + b)), _mm_set_epi32(3, 2, 1, 0));
+            std::copy_n(start, 16, x);
+            for (int round = 0; round < 10; ++round) {
+                quarterRoundSse2(x[0], x[4], x[8], x[12]);
+                quarterRoundSse2(x[1], x[5], x[9], x[13]);
+                quarterRoundSse2(x[2], x[6], x[10], x[14]);
+                quarterRoundSse2(x[3], x[7], x[11], x[15]);
+                quarterRoundSse2(x[0], x[5], x[10], x[15]);
+                quarterRoundSse2(x[1], x[6], x[11], x[12]);
+                quarterRoundSse2(x[2], x[7], x[8], x[13]);
+                quarterRoundSse2(x[3], x[4], x[9], x[14]);
+            }
+            for (int i = 0; i < 16; ++i) {
+                x[i] = _mm_add_epi32(x[i], start[i]);
+            }
+            for (int group = 0; group < 4; ++group) {
+                auto* words = x + 4 * group;
+                auto low01 = _mm_unpacklo_epi32(words[0], words[1]);
+                auto low23 = _mm_unpacklo_epi32(words[2], words[3]);
+                auto high01 = _mm_unpackhi_epi32(words[0], words[1]);
+                auto high23 = _mm_unpackhi_epi32(words[2], words[3]);
+                __m128i rows[4] = {_mm_unpacklo_epi64(low01, low23), _mm_unpackhi_epi64(low01, low23),
+                                   _mm_unpacklo_epi64(high01, high23), _mm_unpackhi_epi64(high01, high23)};
+                for (std::size_t block = 0; block < 4; ++block) {
+                    auto offset = (b + block) * ChaCha20::blockSize + 16 * group;
+                    auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset),
+                                     _mm_xor_si128(value, rows[block]));
+                }
+            }
+        }
+        auto offset = b * ChaCha20::blockSize;
+        blocksScalar(initial, counter + b, source + offset, destination + offset, blocks - b);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i rotateAvx2(__m256i x, int n) {
+        return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+    }
+
+    __attribute__((target("avx2")))
+    inline void quarterRoundAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i rotate16,
+                                 __m256i rotate8) {
+        // Rotations by whole bytes are a single shuffle.
+        a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate16);
+        c = _mm256_add_epi32(c, d); b = rotateAvx2(_mm256_xor_si256(b, c), 12);
+        a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate8);
+        c = _mm256_add_epi32(c, d); b = rotateAvx2(_mm256_xor_si256(b, c), 7);
+    }
+
+    __attribute__((target("avx2")))
+    inline void xorAvx2(const std::byte* source, std::byte* destination, __m256i keystream) {
+        auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), _mm256_xor_si256(value, keystream));
+    }
+
+    __attribute__((target("avx2")))
+    void blocksAvx2(const std::uint32_t* initial, std::uint32_t counter, const std::byte* source,
+                    std::byte* destination, std::size_t blocks) {
+        const auto rotate16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                               2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+        const auto rotate8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                              3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+        std::size_t b = 0;
+        for (; b + 8 <= blocks; b += 8) {
+            __m256i start[16];
+            __m256i x[16];
+            for (int i = 0; i < 16; ++i) {
+                start[i] = _mm256_set1_epi32(static_cast<int>(initial[i]));
+            }
+            start[12] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter + b)),
+                                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            std::copy_n(start, 16, x);
+            for (int round = 0; round < 10; ++round) {
+                quarterRoundAvx2(x[0], x[4], x[8], x[12], rotate16, rotate8);
+                quarterRoundAvx2(x[1], x[5], x[9], x[13], rotate16, rotate8);
+                quarterRoundAvx2(x[2], x[6], x[10], x[14], rotate16, rotate8);
+                quarterRoundAvx2(x[3], x[7], x[11], x[15], rotate16, rotate8);
+                quarterRoundAvx2(x[0], x[5], x[10], x[15], rotate16, rotate8);
+                quarterRoundAvx2(x[1], x[6], x[11], x[12], rotate16, rotate8);
+                quarterRoundAvx2(x[2], x[7], x[8], x[13], rotate16, rotate8);
+                quarterRoundAvx2(x[3], x[4], x[9], x[14], rotate16, rotate8);
+            }
+            // Transposing within the 128-bit lanes leaves block j in the low lane and block j + 4 in the high lane.
+            __m256i rows[4][4];
+            for (int group = 0; group < 4; ++group) {
+                auto* words = x + 4 * group;
+                for (int i = 0; i < 4; ++i) {
+                    words[i] = _mm256_add_epi32(words[i], start[4 * group + i]);
+                }
+                auto low01 = _mm256_unpacklo_epi32(words[0], words[1]);
+                auto low23 = _mm256_unpacklo_epi32(words[2], words[3]);
+                auto high01 = _mm256_unpackhi_epi32(words[0], words[1]);
+                auto high23 = _mm256_unpackhi_epi32(words[2], words[3]);
+                rows[group][0] = _mm256_unpacklo_epi64(low01, low23);
+                rows[group][1] = _mm256_unpackhi_epi64(low01, low23);
+                rows[group][2] = _mm256_unpacklo_epi64(high01, high23);
+                rows[group][3] = _mm256_unpackhi_epi64(high01, high23);
+            }
+            for (std::size_t block = 0; block < 4; ++block) {
+                auto low = (b + block) * ChaCha20::blockSize;
+                auto high = low + 4 * ChaCha20::blockSize;
+                xorAvx2(source + low, destination + low,
+                        _mm256_permute2x128_si256(rows[0][block], rows[1][block], 0x20));
+                xorAvx2(source + low + 32, destination + low + 32,
+                        _mm256_permute2x128_si256(rows[2][block], rows[3][block], 0x20));
+                xorAvx2(source + high, destination + high,
+                        _mm256_permute2x128_si256(rows[0][block], rows[1][block], 0x31));
+                xorAvx2(source + high + 32, destination + high + 32,
+                        _mm256_permute2x128_si256(rows[2][block], rows[3][block], 0x31));
+            }
+        }
+        auto offset = b * ChaCha20::blockSize;
+        blocksSse2(initial, counter + b, source + offset, destination + offset, blocks - b);
+    }
+#endif
+
+    BlocksFunction blocksFunction(FileEncryptor::Kernel kernel) {
+        switch (kernel) {
+#ifdef PASSWORDMANAGER_X86
+            case FileEncryptor::Kernel::SSE2 : return blocksSse2;
+            case FileEncryptor::Kernel::AVX2 : return blocksAvx2;
+#endif
+            default : return blocksScalar;
+        }
+    }
+
+    std::uint32_t loadWord(const std::byte* data) {
+        std::uint32_t word = 0;
+        for (int k = 3; k >= 0; --k) {
+            word = word << 8 | std::to_integer<std::uint32_t>(data[k]);
+        }
+        return word;
+    }
+}
+
+ChaCha20::ChaCha20(std::span<const std::byte, 32> key, std::span<const std::byte, 12> nonce,
+                   FileEncryptor::Kernel kernel) : kernel(kernel) {
+    // "expand 32-byte k"
+    initial[0] = 0x61707865;
+    initial[1] = 0x3320646e;
+    initial[2] = 0x79622d32;
+    initial[3] = 0x6b206574;
+    for (int i = 0; i < 8; ++i) {
+        initial[4 + i] = loadWord(key.data() + 4 * i);
+    }
+    initial[12] = 0;
+    for (int i = 0; i < 3; ++i) {
+        initial[13 + i] = loadWord(nonce.data() + 4 * i);
+    }
+}
+
+void ChaCha20::apply(std::span<const std::byte> source, std::span<std::byte> destination,
+                     std::size_t offset) const {
+    auto counter = static_cast<std::uint32_t>(offset / blockSize);
+    auto start = offset % blockSize;
+    std::size_t done = 0;
+    if (start != 0) {
+        done = std::min(source.size(), blockSize - start);
+        applyPartial(initial.data(), counter++, start, source.data(), destination.data(), done);
+    }
+    auto blocks = (source.size() - done) / blockSize;
+    blocksFunction(kernel)(initial.data(), counter, source.data() + done, destination.data() + done, blocks);
+    done += blocks * blockSize;
+    counter += static_cast<std::uint32_t>(blocks);
+    if (done < source.size()) {
+        applyPartial(initial.data(), counter, 0, source.data() + done, destination.data() + done,
+                     source.size() - done);
+    }
+}
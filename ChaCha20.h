@@ -0,0 +1,48 @@
+#ifndef PASSWORDMANAGER_CHACHA20_H
+#define PASSWORDMANAGER_CHACHA20_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "CipherEngine.h"
+#include "FileEncryptor.h"
+
+/**
+* @brief The ChaCha20 stream cipher of RFC 8439, with a 32-bit block counter starting at 0.
+* The keystream is produced several blocks at a time by the widest kernel the CPU supports: 1 block per call for
+* the scalar kernel, 4 interleaved blocks in SSE2 registers and 8 in AVX2 registers.
+*/
+class ChaCha20 : public CipherEngine {
+public:
+    /**
+     * Size of a block of keystream in bytes.
+     */
+    static constexpr std::size_t blockSize = 64;
+private:
+    /**
+     * The state every block starts from: the constants, the key, a zero counter and the nonce.
+     */
+    std::array<std::uint32_t, 16> initial;
+    FileEncryptor::Kernel kernel;
+public:
+    /**
+    @brief Constructs the cipher.
+    @param key The 256-bit key.
+    @param nonce The 96-bit nonce.
+    @param kernel The kernel to produce the keystream with. Must be supported by the CPU.
+    */
+    ChaCha20(std::span<const std::byte, 32> key, std::span<const std::byte, 12> nonce,
+             FileEncryptor::Kernel kernel = FileEncryptor::bestKernel());
+    /**
+    @brief Encrypts or decrypts data. Streams are limited to 2^32 blocks (256 GiB).
+    @param source The data to process.
+    @param destination The buffer receiving the result.
+    @param offset Position of the source within the stream.
+    */
+    void apply(std::span<const std::byte> source, std::span<std::byte> destination,
+               std::size_t offset) const override;
+};
+
+
+#endif //PASSWORDMANAGER_CHACHA20_H
@@ -0,0 +1,62 @@
+#include "CipherEngine.h"
+#include <algorithm>
+#include <random>
+#include "ChaCha20.h"
+#include "FileEncryptor.h"
+
+namespace {
+    /**
+    @brief The repeating-key XOR of files written before the vault header existed.
+    */
+    class XorEngine : public CipherEngine {
+        std::string key;
+    public:
+        explicit XorEngine(std::string_view key) : key(key) {}
+
+        void apply(std::span<const std::byte> source, std::span<std::byte> destination,
+                   std::size_t offset) const override {
+            FileEncryptor().apply_xor(source, destination, key, offset);
+        }
+    };
+}
+
+CipherParams CipherParams::generate(Cipher cipher) {
+    // random_device reads the operating system's random source, which is suitable for salts and nonces.
+    std::random_device random;
+    CipherParams params;
+    params.cipher = cipher;
+    auto fill = [&](std::span<std::byte> bytes) {
+        for (auto& byte : bytes) byte = static_cast<std::byte>(random());
+    };
+    fill(params.salt);
+    fill(params.nonce);
+    return params;
+}
+
+void CipherParams::appendTo(std::string &out) const {
+    out += static_cast<char>(cipher);
+    for (auto byte : salt) out += static_cast<char>(byte);
+    for (auto byte : nonce) out += static_cast<char>(byte);
+}
+
+std::optional<CipherParams> CipherParams::read(std::span<const std::byte> data) {
+    if (data.size() < storedSize) return std::nullopt;
+    CipherParams params;
+    params.cipher = static_cast<Cipher>(data[0]);
+    if (params.cipher != Cipher::ChaCha20 && params.cipher != Cipher::Xor) return std::nullopt;
+    std::copy_n(data.begin() + 1, params.salt.size(), params.salt.begin());
+    std::copy_n(data.begin() + 1 + params.salt.size(), params.nonce.size(), params.nonce.begin());
+    return params;
+}
+
+Sha256::Digest CipherParams::deriveKey(std::string_view password) const {
+    Sha256 sha;
+    sha.update(salt);
+    sha.update(password);
+    return sha.finish();
+}
+
+std::unique_ptr<CipherEngine> CipherEngine::create(const CipherParams &params, std::string_view password) {
+    if (params.cipher == Cipher::Xor) return std::make_unique<XorEngine>(password);
+    return std::make_unique<ChaCha20>(params.deriveKey(password), params.nonce);
+}
@@ -0,0 +1,92 @@
+#ifndef PASSWORDMANAGER_CIPHERENGINE_H
+#define PASSWORDMANAGER_CIPHERENGINE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include "Sha256.h"
+
+/**
+* @brief Ciphers data can be encrypted with. The values are stored in files and must not change.
+*/
+enum class Cipher : std::uint8_t {
+    /**
+     * XOR with the repeating password, used by files written before the vault header existed.
+     */
+    Xor = 0,
+    /**
+     * The ChaCha20 stream cipher of RFC 8439, keyed with the SHA-256 digest of the salt and the password.
+     */
+    ChaCha20 = 1
+};
+
+/**
+* @brief The parameters a file was encrypted with, stored unencrypted in front of the data.
+* A new salt and nonce are drawn every time a file is written, so no keystream is ever used for two contents.
+*/
+struct CipherParams {
+    Cipher cipher = Cipher::ChaCha20;
+    std::array<std::byte, 16> salt{};
+    std::array<std::byte, 12> nonce{};
+    /**
+     * Size of the parameters when stored: the cipher (1 byte), the salt and the nonce.
+     */
+    static constexpr std::size_t storedSize = 1 + 16 + 12;
+    /**
+    @brief Draws a random salt and nonce for a new file.
+    @param cipher The cipher the file is encrypted with.
+    @return The parameters.
+    */
+    static CipherParams generate(Cipher cipher = Cipher::ChaCha20);
+    /**
+    @brief Appends the stored form of the parameters to a string.
+    @param out The string to append to.
+    */
+    void appendTo(std::string& out) const;
+    /**
+    @brief Reads parameters stored by appendTo.
+    @param data The stored parameters, at least storedSize bytes.
+    @return The parameters, or an empty optional if the cipher is unknown.
+    */
+    static std::optional<CipherParams> read(std::span<const std::byte> data);
+    /**
+    @brief Derives the key of the file from the password: the SHA-256 digest of the salt and the password.
+    @param password The password of the file.
+    @return The key.
+    */
+    Sha256::Digest deriveKey(std::string_view password) const;
+};
+
+/**
+* @brief Interface of the stream ciphers files are encrypted with.
+* A stream cipher XORs the data with a keystream, so encrypting and decrypting are the same operation, and any part
+* of a file can be processed on its own given its offset. Engines are immutable and can be shared between threads.
+*/
+class CipherEngine {
+public:
+    virtual ~CipherEngine() = default;
+    /**
+    @brief Encrypts or decrypts data.
+    @param source The data to process.
+    @param destination The buffer receiving the result. Must be at least as large as the source and either the same
+     buffer as the source or not overlapping it.
+    @param offset Position of the source within the stream.
+    */
+    virtual void apply(std::span<const std::byte> source, std::span<std::byte> destination,
+                       std::size_t offset) const = 0;
+    /**
+    @brief Creates the engine for a file.
+    @param params The parameters the file is encrypted with.
+    @param password The password of the file.
+    @return The engine.
+    */
+    static std::unique_ptr<CipherEngine> create(const CipherParams& params, std::string_view password);
+};
+
+
+#endif //PASSWORDMANAGER_CIPHERENGINE_H
@@ -4,6 +4,7 @@
 
 #include <exception>
 #include <string>
+#include <utility>
 
 /**
 @brief Class representing an exception that occurs during decryption.
@@ -22,6 +23,12 @@ public:
     DecryptionException()
             : message("Decryption error occurred.\n") {}
     /**
+    * @brief Constructs a DecryptionException object with a specific error message.
+    * @param message The error message.
+    */
+    explicit DecryptionException(std::string message)
+            : message(std::move(message)) {}
+    /**
     * @brief Retrieves the error message associated with the exception.
     * @return The error message.
     */
@@ -1,7 +1,7 @@
 #include "Entry.h"
 
-Entry::Entry(const string &category, const string &name, const string &password, const string &login,
-             const string &website) : category(category), name(name), password(password), login(login),
+Entry::Entry(std::string_view category, std::string_view name, std::string_view password, std::string_view login,
+             std::string_view website) : category(category), name(name), password(password), login(login),
                                       website(website) {}
 
 auto Entry::getFileString() const -> std::string {
@@ -18,7 +18,7 @@ const std::string & Entry::getName() const {
     return name;
 }
 
-auto Entry::getCategory() const -> std::string {
+auto Entry::getCategory() const -> const std::string& {
     return category;
 }
 
@@ -54,6 +54,31 @@ void Entry::setWebsite(const std::string &website) {
     Entry::website = website;
 }
 
+void Entry::setField(EntryField field, const string &value) {
+    switch (field) {
+        case EntryField::Name : {
+            setName(value);
+            break;
+        }
+        case EntryField::Category : {
+            setCategory(value);
+            break;
+        }
+        case EntryField::Login : {
+            setLogin(value);
+            break;
+        }
+        case EntryField::Website : {
+            setWebsite(value);
+            break;
+        }
+        case EntryField::Password : {
+            setPassword(value);
+            break;
+        }
+    }
+}
+
 bool Entry::compareEntries(const Entry &a, const Entry &b, int param1, int param2) {
     switch (param1) {
         case 1 : {
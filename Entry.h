@@ -1,11 +1,21 @@
 #ifndef PASSWORDMANAGER_ENTRY_H
 #define PASSWORDMANAGER_ENTRY_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using std::string;
 /**
+* @brief Fields of a password entry. The numbers match the parameters of Entry::compareEntries.
+*/
+enum class EntryField { Name = 1, Category = 2, Login = 3, Website = 4, Password = 5 };
+/**
+* @brief Identifier of an entry stored in a password list. It stays the same until the entry is removed.
+*/
+using EntryId = std::uint32_t;
+/**
 * @brief Class representing a password entry.
 * The Entry class represents a password entry and contains attributes such as the category, name, password, login, and website.
 * It provides methods to retrieve and modify these attributes.
@@ -41,8 +51,8 @@ public:
     @param login The login associated with the entry.
     @param website The website associated with the entry.
     */
-    Entry(const string &category, const string &name, const string &password, const string &login,
-          const string &website);
+    Entry(std::string_view category, std::string_view name, std::string_view password, std::string_view login,
+          std::string_view website);
     /**
     @brief Retrieves a formatted string representation of the entry with parameters separated by comas,
      intended to be encrypted and written to a file.
@@ -59,7 +69,7 @@ public:
     @brief Retrieves the category of the entry.
     @return The category of the entry.
     */
-    auto getCategory() const ->  string;
+    auto getCategory() const -> const string&;
     /**
     @brief Retrieves the name of the entry.
     @return The name of the entry.
@@ -106,6 +116,12 @@ public:
     */
     void setWebsite(const string &website);
     /**
+    @brief Sets the given field of the entry.
+    @param field The field to set.
+    @param value The new value of the field.
+    */
+    void setField(EntryField field, const string &value);
+    /**
     @brief Checks if this entry is equal to another entry.
     @param other The other entry to compare.
     @return True if the entries are equal, false otherwise.
@@ -0,0 +1,361 @@
+#include "EntryExchange.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+
+namespace {
+    /**
+     * Names of the fields in the header row and the JSON members, in the order of EntryField.
+     */
+    constexpr std::array<std::string_view, 5> fieldNames = {"name", "category", "login", "website", "password"};
+    /**
+     * The fields in the order exported entries list them.
+     */
+    constexpr std::array<EntryField, 5> exportOrder = {EntryField::Category, EntryField::Name, EntryField::Password,
+                                                       EntryField::Login, EntryField::Website};
+
+    std::size_t position(EntryField field) {
+        return static_cast<std::size_t>(field) - 1;
+    }
+
+    std::string_view fieldOf(const EntryRef& entry, EntryField field) {
+        switch (field) {
+            case EntryField::Name : return entry.getName();
+            case EntryField::Category : return entry.getCategory();
+            case EntryField::Login : return entry.getLogin();
+            case EntryField::Website : return entry.getWebsite();
+            case EntryField::Password : return entry.getPassword();
+        }
+        return {};
+    }
+
+    /**
+    @brief Parser of the flat JSON objects JSON Lines files hold, one per line.
+    */
+    class JsonObjectParser {
+        std::string_view text;
+        std::size_t i = 0;
+
+        void skipSpace() {
+            while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n')) ++i;
+        }
+
+        void expect(char c) {
+            skipSpace();
+            if (i >= text.size() || text[i] != c) throw std::runtime_error(string("expected '") + c + "'");
+            ++i;
+        }
+
+        unsigned hexDigits() {
+            if (i + 4 > text.size()) throw std::runtime_error("truncated \\u escape");
+            unsigned value = 0;
+            for (int k = 0; k < 4; ++k) {
+                char c = text[i++];
+                value <<= 4;
+                if (c >= '0' && c <= '9') value |= c - '0';
+                else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+                else throw std::runtime_error("invalid \\u escape");
+            }
+            return value;
+        }
+
+        static void appendUtf8(string& out, unsigned code) {
+            if (code < 0x80) {
+                out += static_cast<char>(code);
+            } else if (code < 0x800) {
+                out += static_cast<char>(0xc0 | code >> 6);
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            } else if (code < 0x10000) {
+                out += static_cast<char>(0xe0 | code >> 12);
+                out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            } else {
+                out += static_cast<char>(0xf0 | code >> 18);
+                out += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+                out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            }
+        }
+
+    public:
+        explicit JsonObjectParser(std::string_view text) : text(text) {}
+
+        /**
+        @brief Parses a string literal.
+        */
+        string parseString() {
+            expect('"');
+            string out;
+            while (true) {
+                if (i >= text.size()) throw std::runtime_error("unterminated string");
+                char c = text[i++];
+                if (c == '"') return out;
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (i >= text.size()) throw std::runtime_error("unterminated string");
+                switch (text[i++]) {
+                    case '"' : out += '"'; break;
+                    case '\\' : out += '\\'; break;
+                    case '/' : out += '/'; break;
+                    case 'b' : out += '\b'; break;
+                    case 'f' : out += '\f'; break;
+                    case 'n' : out += '\n'; break;
+                    case 'r' : out += '\r'; break;
+                    case 't' : out += '\t'; break;
+                    case 'u' : {
+                        auto code = hexDigits();
+                        // Characters outside the basic plane are escaped as a surrogate pair.
+                        if (code >= 0xd800 && code < 0xdc00 && text.substr(i, 2) == "\\u") {
+                            i += 2;
+                            auto low = hexDigits();
+                            if (low < 0xdc00 || low >= 0xe000) throw std::runtime_error("invalid surrogate pair");
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                        }
+                        appendUtf8(out, code);
+                        break;
+                    }
+                    default : throw std::runtime_error("invalid escape");
+                }
+            }
+        }
+
+        /**
+        @brief Parses a member value: a string, or null for an empty field. Numbers and booleans are kept as written.
+        */
+        string parseValue() {
+            skipSpace();
+            if (i < text.size() && text[i] == '"') return parseString();
+            auto start = i;
+            while (i < text.size() && text[i] != ',' && text[i] != '}' && text[i] != ' ' && text[i] != '\t') ++i;
+            auto literal = text.substr(start, i - start);
+            if (literal == "null") return {};
+            if (literal.empty() || literal[0] == '{' || literal[0] == '[') {
+                throw std::runtime_error("member values must be strings");
+            }
+            return string(literal);
+        }
+
+        /**
+        @brief Parses the object, calling visit with the name and value of every member.
+        */
+        template <typename Visit>
+        void parseObject(Visit&& visit) {
+            expect('{');
+            skipSpace();
+            if (i < text.size() && text[i] == '}') {
+                ++i;
+            } else {
+                while (true) {
+                    auto name = parseString();
+                    expect(':');
+                    visit(name, parseValue());
+                    skipSpace();
+                    if (i < text.size() && text[i] == ',') {
+                        ++i;
+                        continue;
+                    }
+                    expect('}');
+                    break;
+                }
+            }
+            skipSpace();
+            if (i != text.size()) throw std::runtime_error("unexpected text after the object");
+        }
+    };
+}
+
+std::optional<ExchangeFormat> exchangeFormatOf(std::string_view fileName) {
+    if (fileName.ends_with(".csv")) return ExchangeFormat::Csv;
+    if (fileName.ends_with(".jsonl") || fileName.ends_with(".ndjson")) return ExchangeFormat::JsonLines;
+    return std::nullopt;
+}
+
+EntryReader::EntryReader(std::istream &input, ExchangeFormat format) : input(input), format(format) {
+    columns.fill(-1);
+    if (format != ExchangeFormat::Csv) return;
+    if (!readCsvRecord()) fail("missing header row");
+    for (std::size_t column = 0; column < fields.size(); ++column) {
+        if (auto field = fieldNamed(fields[column]); field && columns[position(*field)] < 0) {
+            columns[position(*field)] = static_cast<int>(column);
+        }
+    }
+    if (columns[position(EntryField::Name)] < 0 || columns[position(EntryField::Category)] < 0) {
+        fail("the header row needs a name and a category column");
+    }
+}
+
+std::optional<EntryField> EntryReader::fieldNamed(std::string_view name) {
+    string lowered;
+    for (char c : name) {
+        if (c != ' ') lowered += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    if (lowered == "url") return EntryField::Website;
+    if (lowered == "username") return EntryField::Login;
+    for (std::size_t i = 0; i < fieldNames.size(); ++i) {
+        if (lowered == fieldNames[i]) return static_cast<EntryField>(i + 1);
+    }
+    return std::nullopt;
+}
+
+void EntryReader::fail(const string &message) const {
+    throw std::runtime_error("Line " + std::to_string(recordLine) + ": " + message);
+}
+
+bool EntryReader::readCsvRecord() {
+    auto* buffer = input.rdbuf();
+    recordLine = lineNumber + 1;
+    fields.assign(1, string());
+    std::size_t size = 0;
+    bool quoted = false;
+    bool inQuotes = false;
+    bool started = false;
+    while (true) {
+        auto c = buffer->sbumpc();
+        if (c == std::char_traits<char>::eof()) {
+            if (inQuotes) fail("unterminated quoted field");
+            return started;
+        }
+        started = true;
+        if (++size > maxRecordSize) fail("record too long");
+        auto& field = fields.back();
+        if (inQuotes) {
+            if (c != '"') {
+                if (c == '\n') ++lineNumber;
+                field += static_cast<char>(c);
+            } else if (buffer->sgetc() == '"') {
+                buffer->sbumpc();
+                field += '"';
+            } else {
+                inQuotes = false;
+            }
+        } else if (c == '"' && field.empty() && !quoted) {
+            quoted = inQuotes = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+            quoted = false;
+        } else if (c == '\n') {
+            ++lineNumber;
+            return true;
+        } else if (c != '\r' || buffer->sgetc() != '\n') {
+            field += static_cast<char>(c);
+        }
+    }
+}
+
+bool EntryReader::readLine() {
+    auto* buffer = input.rdbuf();
+    recordLine = ++lineNumber;
+    fields.assign(1, string());
+    auto& line = fields[0];
+    while (true) {
+        auto c = buffer->sbumpc();
+        if (c == std::char_traits<char>::eof()) return !line.empty();
+        if (c == '\n') return true;
+        if (line.size() == maxRecordSize) fail("record too long");
+        line += static_cast<char>(c);
+    }
+}
+
+Entry EntryReader::parseJson(std::string_view line) const {
+    std::array<string, 5> values;
+    try {
+        JsonObjectParser(line).parseObject([&](const string& name, string value) {
+            if (auto field = fieldNamed(name)) values[position(*field)] = std::move(value);
+        });
+    } catch (const std::runtime_error& e) {
+        fail(e.what());
+    }
+    auto take = [&](EntryField field) { return std::move(values[position(field)]); };
+    return {take(EntryField::Category), take(EntryField::Name), take(EntryField::Password), take(EntryField::Login),
+            take(EntryField::Website)};
+}
+
+std::optional<Entry> EntryReader::next() {
+    while (true) {
+        if (format == ExchangeFormat::JsonLines) {
+            if (!readLine()) return std::nullopt;
+            auto line = std::string_view(fields[0]);
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos) continue;
+            return parseJson(line);
+        }
+        if (!readCsvRecord()) return std::nullopt;
+        if (fields.size() == 1 && fields[0].empty()) continue;
+        auto take = [&](EntryField field) {
+            auto column = columns[position(field)];
+            return column >= 0 && static_cast<std::size_t>(column) < fields.size() ? std::move(fields[column])
+                                                                                     : string();
+        };
+        return Entry(take(EntryField::Category), take(EntryField::Name), take(EntryField::Password),
+                     take(EntryField::Login), take(EntryField::Website));
+    }
+}
+
+std::size_t EntryReader::line() const {
+    return recordLine;
+}
+
+EntryWriter::EntryWriter(std::ostream &output, ExchangeFormat format) : output(output), format(format) {
+    if (format != ExchangeFormat::Csv) return;
+    for (auto field : exportOrder) {
+        if (!record.empty()) record += ',';
+        record += fieldNames[position(field)];
+    }
+    record += "\r\n";
+    output << record;
+}
+
+void EntryWriter::appendCsv(string &record, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        record += field;
+        return;
+    }
+    record += '"';
+    for (char c : field) {
+        if (c == '"') record += '"';
+        record += c;
+    }
+    record += '"';
+}
+
+void EntryWriter::appendJson(string &json, std::string_view text) {
+    static constexpr char hex[] = "0123456789abcdef";
+    json += '"';
+    for (char c : text) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (byte < 0x20) {
+            json += "\\u00";
+            json += hex[byte >> 4];
+            json += hex[byte & 0xf];
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+}
+
+void EntryWriter::write(const EntryRef &entry) {
+    record.clear();
+    if (format == ExchangeFormat::Csv) {
+        for (auto field : exportOrder) {
+            if (field != exportOrder.front()) record += ',';
+            appendCsv(record, fieldOf(entry, field));
+        }
+        record += "\r\n";
+    } else {
+        for (auto field : exportOrder) {
+            record += field == exportOrder.front() ? '{' : ',';
+            appendJson(record, fieldNames[position(field)]);
+            record += ':';
+            appendJson(record, fieldOf(entry, field));
+        }
+        record += "}\n";
+    }
+    output.write(record.data(), static_cast<std::streamsize>(record.size()));
+}
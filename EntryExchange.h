@@ -0,0 +1,169 @@
+#ifndef PASSWORDMANAGER_ENTRYEXCHANGE_H
+#define PASSWORDMANAGER_ENTRYEXCHANGE_H
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Entry.h"
+#include "EntryStore.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Formats entries can be imported from and exported to.
+*/
+enum class ExchangeFormat {
+    /**
+     * Comma-separated values as described by RFC 4180, with a header row naming the columns.
+     */
+    Csv,
+    /**
+     * One JSON object per line, with the fields of the entry as string members.
+     */
+    JsonLines
+};
+
+/**
+* @brief Reads entries one at a time from a CSV or JSON Lines stream, so files of any size are read in bounded memory.
+* The columns or members category, name, password, login and website are recognized, as are url and username
+* for the website and login, which other password managers export. Other columns and members are ignored.
+*/
+class EntryReader {
+    /**
+     * The stream the entries are read from.
+     */
+    std::istream& input;
+    ExchangeFormat format;
+    /**
+     * Number of lines read so far.
+     */
+    std::size_t lineNumber = 0;
+    /**
+     * The line the last record read started on.
+     */
+    std::size_t recordLine = 0;
+    /**
+     * For CSV, the column of every field in the order of EntryField, or -1 if the file has no such column.
+     */
+    std::array<int, 5> columns{};
+    /**
+     * The fields of the record being read, reused to avoid allocating for every record.
+     */
+    vector<string> fields;
+    /**
+    @brief Reads one CSV record into fields.
+    @return False if the stream ended before the record started.
+    */
+    bool readCsvRecord();
+    /**
+    @brief Reads one line into fields[0].
+    @return False if the stream ended before the line started.
+    */
+    bool readLine();
+    /**
+    @brief Parses a line holding a JSON object into an entry.
+    */
+    Entry parseJson(std::string_view line) const;
+    /**
+    @brief Maps a column or member name to the field it holds.
+    @return The field, or an empty optional if the name is not recognized.
+    */
+    static std::optional<EntryField> fieldNamed(std::string_view name);
+    /**
+    @brief Throws an error about the record being read.
+    */
+    [[noreturn]] void fail(const string& message) const;
+public:
+    /**
+     * Length of the longest record accepted, which keeps a malformed file from being read into memory whole.
+     */
+    static constexpr std::size_t maxRecordSize = 1 << 20;
+    /**
+    @brief Constructs a reader. For CSV, the header row is read.
+    @param input The stream to read from.
+    @param format The format of the stream.
+    @throws std::runtime_error If the CSV header has no category or name column.
+    */
+    EntryReader(std::istream& input, ExchangeFormat format);
+    /**
+    @brief Reads the next entry. Blank lines are skipped.
+    @return The entry, or an empty optional if the stream has ended.
+    @throws std::runtime_error If the record is malformed. The message gives its line.
+    */
+    std::optional<Entry> next();
+    /**
+    @brief Retrieves the line the last entry read started on.
+    @return The line number, starting at 1.
+    */
+    std::size_t line() const;
+};
+
+/**
+* @brief Writes entries one at a time to a CSV or JSON Lines stream, escaping the fields as the format requires.
+*/
+class EntryWriter {
+    /**
+     * The stream the entries are written to.
+     */
+    std::ostream& output;
+    ExchangeFormat format;
+    /**
+     * The record being written, reused to avoid allocating for every entry.
+     */
+    string record;
+    /**
+    @brief Appends a field to a CSV record, quoting it if it holds a comma, a quote or a line break.
+    */
+    static void appendCsv(string& record, std::string_view field);
+public:
+    /**
+    @brief Constructs a writer. For CSV, the header row is written.
+    @param output The stream to write to.
+    @param format The format to write.
+    */
+    EntryWriter(std::ostream& output, ExchangeFormat format);
+    /**
+    @brief Writes an entry.
+    @param entry The entry to write.
+    */
+    void write(const EntryRef& entry);
+    /**
+    @brief Appends text to a string as a JSON string literal.
+    @param json The string to append to.
+    @param text The text to quote and escape.
+    */
+    static void appendJson(string& json, std::string_view text);
+};
+
+/**
+* @brief Counts of what happened to the entries of an import.
+*/
+struct ImportResult {
+    /**
+     * Entries added to the password list.
+     */
+    std::size_t added = 0;
+    /**
+     * Entries skipped because the category already holds an entry with the same name.
+     */
+    std::size_t duplicates = 0;
+    /**
+     * Entries skipped because a field cannot be stored: the name or category is empty, or a field is too long
+     * or contains a comma or a line break.
+     */
+    std::size_t rejected = 0;
+};
+
+/**
+@brief Picks the format of a file from its extension: .csv for CSV, .jsonl or .ndjson for JSON Lines.
+@param fileName The name of the file.
+@return The format, or an empty optional if the extension is not recognized.
+*/
+std::optional<ExchangeFormat> exchangeFormatOf(std::string_view fileName);
+
+
+#endif //PASSWORDMANAGER_ENTRYEXCHANGE_H
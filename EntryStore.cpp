@@ -0,0 +1,237 @@
+#include "EntryStore.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+std::string_view EntryRef::getCategory() const {
+    return store->categoryName(store->category(id));
+}
+
+std::string_view EntryRef::getName() const {
+    return store->field(id, EntryField::Name);
+}
+
+std::string_view EntryRef::getPassword() const {
+    return store->password(id);
+}
+
+void EntryRef::appendPassword(string &out) const {
+    store->appendPassword(id, out);
+}
+
+std::string_view EntryRef::getLogin() const {
+    return store->field(id, EntryField::Login);
+}
+
+std::string_view EntryRef::getWebsite() const {
+    return store->field(id, EntryField::Website);
+}
+
+string EntryRef::getDisplayString() const {
+    return toEntry().getDisplayString();
+}
+
+Entry EntryRef::toEntry() const {
+    return {getCategory(), getName(), getPassword(), getLogin(), getWebsite()};
+}
+
+const char *EntryStore::pack(const std::array<std::string_view, 4> &fields) {
+    std::size_t total = 0;
+    for (auto field : fields) {
+        // Sealed passwords may use the room maxFieldSize leaves.
+        if (field.size() > UINT16_MAX) throw std::length_error("Entry field is longer than 65535 characters");
+        total += field.size();
+    }
+    if (chunkSize - chunkUsed < total) {
+        chunks.push_back(std::make_unique_for_overwrite<char[]>(chunkSize));
+        chunkUsed = 0;
+    }
+    char* start = chunks.back().get() + chunkUsed;
+    char* out = start;
+    for (auto field : fields) {
+        // memcpy with a null source is undefined even for a size of 0.
+        if (!field.empty()) std::memcpy(out, field.data(), field.size());
+        out += field.size();
+    }
+    chunkUsed += total;
+    return start;
+}
+
+std::size_t EntryStore::fieldIndex(EntryField field) {
+    switch (field) {
+        case EntryField::Password : return 1;
+        case EntryField::Login : return 2;
+        case EntryField::Website : return 3;
+        default : return 0;
+    }
+}
+
+EntryId EntryStore::add(CategoryId category, std::string_view name, std::string_view password,
+                        std::string_view login, std::string_view website) {
+    string sealedPassword;
+    if (sealer) {
+        sealedPassword = sealer->seal(password);
+        password = sealedPassword;
+    }
+    Record record{pack({name, password, login, website}), category,
+                  {static_cast<std::uint16_t>(name.size()), static_cast<std::uint16_t>(password.size()),
+                   static_cast<std::uint16_t>(login.size()), static_cast<std::uint16_t>(website.size())}};
+    if (freeIds.empty()) {
+        records.push_back(record);
+        return static_cast<EntryId>(records.size() - 1);
+    }
+    auto id = freeIds.back();
+    freeIds.pop_back();
+    records[id] = record;
+    return id;
+}
+
+EntryId EntryStore::append(EntryStore &&other) {
+    auto first = static_cast<EntryId>(records.size());
+    vector<CategoryId> categories;
+    categories.reserve(other.categoryNames.size());
+    for (const auto& name : other.categoryNames) {
+        categories.push_back(intern(name));
+    }
+    records.reserve(records.size() + other.records.size());
+    for (auto record : other.records) {
+        if (record.category != removed) record.category = categories[record.category];
+        records.push_back(record);
+    }
+    for (auto id : other.freeIds) {
+        freeIds.push_back(first + id);
+    }
+    if (!other.chunks.empty()) {
+        // The chunks of the other store come last, so new fields are packed after its entries.
+        std::move(other.chunks.begin(), other.chunks.end(), std::back_inserter(chunks));
+        chunkUsed = other.chunkUsed;
+    }
+    wastedBytes += other.wastedBytes;
+    other = EntryStore();
+    return first;
+}
+
+void EntryStore::remove(EntryId id) {
+    auto& record = records[id];
+    for (auto size : record.sizes) wastedBytes += size;
+    record.category = removed;
+    freeIds.push_back(id);
+}
+
+bool EntryStore::contains(EntryId id) const {
+    return id < records.size() && records[id].category != removed;
+}
+
+EntryId EntryStore::idLimit() const {
+    return static_cast<EntryId>(records.size());
+}
+
+std::size_t EntryStore::size() const {
+    return records.size() - freeIds.size();
+}
+
+EntryRef EntryStore::get(EntryId id) const {
+    return {*this, id};
+}
+
+std::string_view EntryStore::field(EntryId id, EntryField field) const {
+    const auto& record = records[id];
+    if (field == EntryField::Category) return categoryName(record.category);
+    auto index = fieldIndex(field);
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < index; ++i) offset += record.sizes[i];
+    return {record.fields + offset, record.sizes[index]};
+}
+
+std::string_view EntryStore::password(EntryId id) const {
+    auto stored = field(id, EntryField::Password);
+    return sealer ? sealer->open(stored) : stored;
+}
+
+void EntryStore::appendPassword(EntryId id, string &out) const {
+    auto stored = field(id, EntryField::Password);
+    if (sealer) {
+        sealer->openInto(stored, out);
+    } else {
+        out += stored;
+    }
+}
+
+void EntryStore::seal(std::unique_ptr<PasswordSealer> passwordSealer) {
+    sealer = std::move(passwordSealer);
+}
+
+bool EntryStore::sealed() const {
+    return sealer != nullptr;
+}
+
+CategoryId EntryStore::category(EntryId id) const {
+    return records[id].category;
+}
+
+void EntryStore::setField(EntryId id, EntryField field, std::string_view value) {
+    auto& record = records[id];
+    if (field == EntryField::Category) {
+        record.category = intern(value);
+        return;
+    }
+    std::array<std::string_view, 4> fields = {this->field(id, EntryField::Name), this->field(id, EntryField::Password),
+                                              this->field(id, EntryField::Login), this->field(id, EntryField::Website)};
+    string sealedPassword;
+    if (field == EntryField::Password && sealer) {
+        sealedPassword = sealer->seal(value);
+        value = sealedPassword;
+    }
+    fields[fieldIndex(field)] = value;
+    // The old fields stay where they are, so views of them remain valid until the store is repacked.
+    auto packed = pack(fields);
+    for (auto size : record.sizes) wastedBytes += size;
+    record.fields = packed;
+    record.sizes[fieldIndex(field)] = static_cast<std::uint16_t>(value.size());
+}
+
+CategoryId EntryStore::intern(std::string_view name) {
+    if (auto id = findCategory(name)) return *id;
+    auto id = static_cast<CategoryId>(categoryNames.size());
+    categoryIds.emplace(categoryNames.emplace_back(name), id);
+    return id;
+}
+
+std::optional<CategoryId> EntryStore::findCategory(std::string_view name) const {
+    auto iterator = categoryIds.find(name);
+    if (iterator == categoryIds.end()) return std::nullopt;
+    return iterator->second;
+}
+
+std::string_view EntryStore::categoryName(CategoryId id) const {
+    return categoryNames[id];
+}
+
+std::size_t EntryStore::wasted() const {
+    return wastedBytes;
+}
+
+void EntryStore::repack() {
+    // The cache is keyed by the location of the sealed passwords, which is about to change.
+    if (sealer) sealer->clearCache();
+    auto oldChunks = std::move(chunks);
+    chunks.clear();
+    chunkUsed = chunkSize;
+    for (EntryId id = 0; id < records.size(); ++id) {
+        if (!contains(id)) continue;
+        records[id].fields = pack({field(id, EntryField::Name), field(id, EntryField::Password),
+                                   field(id, EntryField::Login), field(id, EntryField::Website)});
+    }
+    wastedBytes = 0;
+    records.shrink_to_fit();
+}
+
+std::size_t EntryStore::memoryUsage() const {
+    std::size_t usage = records.capacity() * sizeof(Record) + freeIds.capacity() * sizeof(EntryId) +
+                        chunks.size() * chunkSize;
+    for (const auto& name : categoryNames) {
+        usage += sizeof(string) + name.capacity();
+    }
+    return usage + categoryIds.size() * (sizeof(std::string_view) + sizeof(CategoryId) + sizeof(void*));
+}
@@ -0,0 +1,290 @@
+#ifndef PASSWORDMANAGER_ENTRYSTORE_H
+#define PASSWORDMANAGER_ENTRYSTORE_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Entry.h"
+#include "PasswordSealer.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Identifier of a category interned by an EntryStore.
+*/
+using CategoryId = std::uint32_t;
+
+class EntryStore;
+
+/**
+* @brief Read-only view of an entry kept in an EntryStore.
+* It offers the same getters as Entry, but the strings are views into the store. A view stays valid until
+* the entry is removed; the strings it returns are valid until the store is next modified. Passwords of a store
+* that seals them are only valid until PasswordSealer::cacheSize other passwords were read.
+*/
+class EntryRef {
+    const EntryStore* store;
+    EntryId id;
+public:
+    /**
+    @brief Constructs a view of an entry.
+    @param store The store holding the entry.
+    @param id The id of the entry.
+    */
+    EntryRef(const EntryStore& store, EntryId id) : store(&store), id(id) {}
+    /**
+    @brief Retrieves the id of the entry.
+    @return The id of the entry.
+    */
+    EntryId getId() const { return id; }
+    /**
+    @brief Retrieves the category of the entry.
+    @return The category of the entry.
+    */
+    std::string_view getCategory() const;
+    /**
+    @brief Retrieves the name of the entry.
+    @return The name of the entry.
+    */
+    std::string_view getName() const;
+    /**
+    @brief Retrieves the password of the entry.
+    @return The password of the entry.
+    */
+    std::string_view getPassword() const;
+    /**
+    @brief Appends the password of the entry to a string, without keeping a decrypted copy in the store.
+    @param out The string to append to.
+    */
+    void appendPassword(string& out) const;
+    /**
+    @brief Retrieves the login associated with the entry.
+    @return The login associated with the entry.
+    */
+    std::string_view getLogin() const;
+    /**
+    @brief Retrieves the website associated with the entry.
+    @return The website associated with the entry.
+    */
+    std::string_view getWebsite() const;
+    /**
+    @brief Retrieves a formatted string representation of the entry in user readable format.
+    @return A string representing the entry.
+    */
+    string getDisplayString() const;
+    /**
+    @brief Copies the entry out of the store.
+    @return A copy of the entry.
+    */
+    Entry toEntry() const;
+};
+
+/**
+* @brief Class storing the entries of a password list compactly.
+* Every entry is a small fixed-size record. The category is stored as the id of an interned category name and
+* the other fields are packed one after another into large chunks of memory, so storing an entry costs
+* no allocation of its own and scanning the entries touches few cache lines.
+* Changing or removing an entry leaves its old bytes in the chunks; repack() reclaims them.
+* A store given a PasswordSealer keeps the passwords sealed: they are encrypted when stored and only decrypted when
+* read through password() or an EntryRef.
+*/
+class EntryStore {
+    /**
+     * A stored entry. The name, password, login and website are stored in this order starting at fields.
+     */
+    struct Record {
+        const char* fields;
+        CategoryId category;
+        std::array<std::uint16_t, 4> sizes;
+    };
+    /**
+     * Category value marking the record of a removed entry.
+     */
+    static constexpr CategoryId removed = ~CategoryId(0);
+    /**
+     * Size of the chunks the fields are packed into. A chunk always fits the largest possible entry.
+     */
+    static constexpr std::size_t chunkSize = 1 << 20;
+    /**
+     * The records, indexed by entry id.
+     */
+    vector<Record> records;
+    /**
+     * Ids of removed entries, available for reuse.
+     */
+    vector<EntryId> freeIds;
+    /**
+     * Chunks holding the fields of the entries.
+     */
+    vector<std::unique_ptr<char[]>> chunks;
+    /**
+     * Number of bytes used in the last chunk.
+     */
+    std::size_t chunkUsed = chunkSize;
+    /**
+     * Number of bytes in the chunks that belong to changed or removed entries.
+     */
+    std::size_t wastedBytes = 0;
+    /**
+     * Interned category names, indexed by category id. A deque keeps the names in place as it grows.
+     */
+    std::deque<string> categoryNames;
+    /**
+     * The sealer of the passwords, or nullptr if they are stored as they are.
+     */
+    std::unique_ptr<PasswordSealer> sealer;
+    /**
+     * Map of category names to their ids.
+     */
+    std::unordered_map<std::string_view, CategoryId> categoryIds;
+    /**
+    @brief Copies fields into the chunks.
+    @param fields The fields to copy.
+    @return The location of the copied fields.
+    */
+    const char* pack(const std::array<std::string_view, 4>& fields);
+    /**
+    @brief Retrieves the position of a field within the packed fields of a record.
+    */
+    static std::size_t fieldIndex(EntryField field);
+public:
+    /**
+     * Length of the longest field an entry can hold, leaving room for sealing passwords.
+     */
+    static constexpr std::size_t maxFieldSize = UINT16_MAX - PasswordSealer::overhead;
+    /**
+    @brief Stores an entry.
+    @param category The category of the entry.
+    @param name The name of the entry.
+    @param password The password of the entry.
+    @param login The login associated with the entry.
+    @param website The website associated with the entry.
+    @return The id of the entry.
+    @throws std::length_error If a field is longer than maxFieldSize.
+    */
+    EntryId add(CategoryId category, std::string_view name, std::string_view password, std::string_view login,
+                std::string_view website);
+    /**
+    @brief Moves all entries of another store to the end of this one, keeping their order. The fields are not
+     copied: the chunks holding them are handed over. Used to merge entries parsed in parallel.
+     The passwords of the other store are taken as stored, so they must already be sealed if this store seals them.
+    @param other The store to take the entries from. It is left empty.
+    @return The id the first moved entry received. The others follow it.
+    */
+    EntryId append(EntryStore&& other);
+    /**
+    @brief Removes an entry. Its id may be reused by the next entry added.
+    @param id The id of the entry.
+    */
+    void remove(EntryId id);
+    /**
+    @brief Checks if an entry with the given id is stored.
+    @param id The id to check.
+    @return True if the entry is stored, false otherwise.
+    */
+    bool contains(EntryId id) const;
+    /**
+    @brief Retrieves the number of ids in use or available for reuse. All stored entries have smaller ids.
+    @return The upper bound of the stored ids.
+    */
+    EntryId idLimit() const;
+    /**
+    @brief Retrieves the number of stored entries.
+    @return The number of entries.
+    */
+    std::size_t size() const;
+    /**
+    @brief Retrieves a view of an entry.
+    @param id The id of the entry.
+    @return The view of the entry.
+    */
+    EntryRef get(EntryId id) const;
+    /**
+    @brief Retrieves a field of an entry as stored. Passwords are returned sealed if the store seals them.
+    @param id The id of the entry.
+    @param field The field to retrieve.
+    @return A view of the field, valid until the store is repacked.
+    */
+    std::string_view field(EntryId id, EntryField field) const;
+    /**
+    @brief Retrieves the password of an entry, decrypting it if the store seals passwords.
+    @param id The id of the entry.
+    @return A view of the password, valid until the store is repacked, and for a sealed password until
+     PasswordSealer::cacheSize other passwords were read.
+    */
+    std::string_view password(EntryId id) const;
+    /**
+    @brief Appends the password of an entry to a string, decrypting it without caching it if the store seals
+     passwords.
+    @param id The id of the entry.
+    @param out The string to append to.
+    */
+    void appendPassword(EntryId id, string& out) const;
+    /**
+    @brief Starts sealing passwords. Must be called while the store is empty, or before appending entries that were
+     sealed with the same sealer.
+    @param passwordSealer The sealer.
+    */
+    void seal(std::unique_ptr<PasswordSealer> passwordSealer);
+    /**
+    @brief Checks if the store seals passwords.
+    @return True if passwords are sealed, false if they are stored as they are.
+    */
+    bool sealed() const;
+    /**
+    @brief Retrieves the category of an entry.
+    @param id The id of the entry.
+    @return The id of the category.
+    */
+    CategoryId category(EntryId id) const;
+    /**
+    @brief Changes a field of an entry. Views of the previous value stay valid until the store is repacked.
+    @param id The id of the entry.
+    @param field The field to change. Changing EntryField::Category interns the new category.
+    @param value The new value of the field. A password is sealed if the store seals passwords.
+    @throws std::length_error If the value is longer than maxFieldSize.
+    */
+    void setField(EntryId id, EntryField field, std::string_view value);
+    /**
+    @brief Retrieves the id of a category name, interning it if it is new.
+    @param name The name of the category.
+    @return The id of the category.
+    */
+    CategoryId intern(std::string_view name);
+    /**
+    @brief Retrieves the id of a category name without interning it.
+    @param name The name of the category.
+    @return The id of the category, or an empty optional if the name was never interned.
+    */
+    std::optional<CategoryId> findCategory(std::string_view name) const;
+    /**
+    @brief Retrieves the name of a category. The name stays valid for the lifetime of the store.
+    @param id The id of the category.
+    @return The name of the category.
+    */
+    std::string_view categoryName(CategoryId id) const;
+    /**
+    @brief Retrieves the number of bytes held by changed or removed entries.
+    @return The number of wasted bytes.
+    */
+    std::size_t wasted() const;
+    /**
+    @brief Packs the fields of the stored entries into new chunks, releasing the space held by changed or removed
+     entries. All views of the fields are invalidated.
+    */
+    void repack();
+    /**
+    @brief Retrieves the memory used by the store.
+    @return The number of bytes allocated for the records, the chunks and the category names.
+    */
+    std::size_t memoryUsage() const;
+};
+
+
+#endif //PASSWORDMANAGER_ENTRYSTORE_H
@@ -1,17 +1,178 @@
 #include "FileEncryptor.h"
+#include <algorithm>
+#include <array>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PASSWORDMANAGER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * Longest key that is pre-expanded for the vectorized kernels. Longer keys use the scalar kernel.
+     */
+    constexpr std::size_t maxExpandedKey = 256;
+    /**
+     * Width of the widest register used by a kernel.
+     */
+    constexpr std::size_t maxWidth = 32;
+
+    using KernelFunction = void (*)(const std::byte* source, std::byte* destination, std::size_t size,
+                                    const std::byte* pattern, std::size_t keySize, std::size_t phase);
+
+    /**
+    @brief XORs the data byte by byte, starting at the given phase within the key.
+    */
+    inline void xorTail(const std::byte* source, std::byte* destination, std::size_t size, const std::byte* key,
+                        std::size_t keySize, std::size_t phase) {
+        for (std::size_t i = 0; i < size; ++i) {
+            destination[i] = source[i] ^ key[phase];
+            if (++phase == keySize) phase = 0;
+        }
+    }
+
+    void xorScalar(const std::byte* source, std::byte* destination, std::size_t size, const std::byte* key,
+                   std::size_t keySize, std::size_t phase) {
+        xorTail(source, destination, size, key, keySize, phase);
+    }
+
+#ifdef PASSWORDMANAGER_X86
+    // The vectorized kernels take a pattern holding the key repeated for keySize + register width bytes,
+    // so the key bytes for any block are a single unaligned load starting at the block's phase within the key.
+
+    __attribute__((target("sse2")))
+    void xorSse2(const std::byte* source, std::byte* destination, std::size_t size, const std::byte* pattern,
+                 std::size_t keySize, std::size_t phase) {
+        const std::size_t advance = 16 % keySize;
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + phase));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_xor_si128(value, mask));
+            phase += advance;
+            if (phase >= keySize) phase -= keySize;
+        }
+        xorTail(source + i, destination + i, size - i, pattern, keySize, phase);
+    }
+
+    __attribute__((target("avx2")))
+    void xorAvx2(const std::byte* source, std::byte* destination, std::size_t size, const std::byte* pattern,
+                 std::size_t keySize, std::size_t phase) {
+        const std::size_t advance = 32 % keySize;
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+            auto mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + phase));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_xor_si256(value, mask));
+            phase += advance;
+            if (phase >= keySize) phase -= keySize;
+        }
+        xorTail(source + i, destination + i, size - i, pattern, keySize, phase);
+    }
+#endif
+
+    KernelFunction kernelFunction(FileEncryptor::Kernel kernel) {
+        switch (kernel) {
+#ifdef PASSWORDMANAGER_X86
+            case FileEncryptor::Kernel::SSE2 : return xorSse2;
+            case FileEncryptor::Kernel::AVX2 : return xorAvx2;
+#endif
+            default : return xorScalar;
+        }
+    }
+}
 
 auto FileEncryptor::encrypt(const std::string& data, const std::string& key) -> std::string {
     return apply_xor(data, key);
 }
 
+void FileEncryptor::encrypt(std::span<std::byte> data, std::string_view key) {
+    apply_xor(data, key);
+}
+
 auto FileEncryptor::decrypt(const std::string &data, const std::string &key) -> std::string {
     return apply_xor(data, key);
 }
 
+void FileEncryptor::decrypt(std::span<std::byte> data, std::string_view key) {
+    apply_xor(data, key);
+}
+
+void FileEncryptor::decrypt(std::span<const std::byte> source, std::span<std::byte> destination,
+                            std::string_view key, std::size_t offset) {
+    apply_xor(source, destination, key, offset);
+}
+
+void FileEncryptor::encrypt(std::span<std::byte> data, std::string_view key, std::size_t offset) {
+    apply_xor(data, data, key, offset);
+}
+
+void FileEncryptor::decrypt(std::span<std::byte> data, std::string_view key, std::size_t offset) {
+    apply_xor(data, data, key, offset);
+}
+
+void FileEncryptor::encrypt(std::span<std::byte> data, const CipherEngine &engine, std::size_t offset) {
+    engine.apply(data, data, offset);
+}
+
+void FileEncryptor::decrypt(std::span<const std::byte> source, std::span<std::byte> destination,
+                            const CipherEngine &engine, std::size_t offset) {
+    engine.apply(source, destination, offset);
+}
+
 std::string FileEncryptor::apply_xor(const std::string &data, const std::string &key) {
     std::string result(data);
-    for (std::size_t i = 0; i < data.length(); ++i) {
-        result[i] ^= key[i % key.length()];
-    }
+    apply_xor(std::as_writable_bytes(std::span(result)), key);
     return result;
 }
+
+void FileEncryptor::apply_xor(std::span<std::byte> data, std::string_view key) {
+    apply_xor(data, data, key);
+}
+
+void FileEncryptor::apply_xor(std::span<std::byte> data, std::string_view key, Kernel kernel) {
+    apply_xor(data, data, key, kernel);
+}
+
+void FileEncryptor::apply_xor(std::span<const std::byte> source, std::span<std::byte> destination,
+                              std::string_view key, std::size_t offset) {
+    static const Kernel best = bestKernel();
+    apply_xor(source, destination, key, best, offset);
+}
+
+void FileEncryptor::apply_xor(std::span<const std::byte> source, std::span<std::byte> destination,
+                              std::string_view key, Kernel kernel, std::size_t offset) {
+    if (source.empty()) return;
+    if (key.empty()) {
+        if (source.data() != destination.data()) std::copy(source.begin(), source.end(), destination.begin());
+        return;
+    }
+    auto keyBytes = std::as_bytes(std::span(key));
+    auto phase = offset % key.size();
+    if (kernel == Kernel::Scalar || key.size() > maxExpandedKey) {
+        xorScalar(source.data(), destination.data(), source.size(), keyBytes.data(), keyBytes.size(), phase);
+        return;
+    }
+    std::array<std::byte, maxExpandedKey + maxWidth> pattern;
+    for (std::size_t i = 0; i < key.size() + maxWidth; ++i) {
+        pattern[i] = keyBytes[i % key.size()];
+    }
+    kernelFunction(kernel)(source.data(), destination.data(), source.size(), pattern.data(), key.size(), phase);
+}
+
+bool FileEncryptor::kernelSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar : return true;
+#ifdef PASSWORDMANAGER_X86
+        case Kernel::SSE2 : return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2 : return __builtin_cpu_supports("avx2");
+#endif
+        default : return false;
+    }
+}
+
+FileEncryptor::Kernel FileEncryptor::bestKernel() {
+    if (kernelSupported(Kernel::AVX2)) return Kernel::AVX2;
+    if (kernelSupported(Kernel::SSE2)) return Kernel::SSE2;
+    return Kernel::Scalar;
+}
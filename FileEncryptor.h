@@ -2,16 +2,25 @@
 #define PASSWORDMANAGER_FILEENCRYPTOR_H
 
 
+#include <cstddef>
+#include <span>
 #include <string>
+#include <string_view>
+#include "CipherEngine.h"
 
 /**
 * @brief Class representing a file encryptor.
 * The FileEncryptor class provides encryption and decryption functionality for files.
-* It contains functions to encrypt and decrypt data using a specified key.
+* It contains functions to encrypt and decrypt data using a specified key, either with a CipherEngine
+* or with the repeating-key XOR files were encrypted with before the engines existed.
 */
 
 class FileEncryptor {
 public:
+    /**
+    * @brief Implementations of the XOR operation. The widest one supported by the CPU is picked at runtime.
+    */
+    enum class Kernel { Scalar, SSE2, AVX2 };
     /**
     @brief Encrypts the provided data using the specified key.
     @param data The data to be encrypted.
@@ -20,6 +29,12 @@ public:
     */
     auto encrypt(const std::string& data, const std::string& key) -> std::string;
     /**
+    @brief Encrypts the provided data in place using the specified key.
+    @param data The data to be encrypted.
+    @param key The encryption key.
+    */
+    void encrypt(std::span<std::byte> data, std::string_view key);
+    /**
     @brief Decrypts the provided data using the specified key.
     @param data The data to be decrypted.
     @param key The decryption key.
@@ -27,12 +42,102 @@ public:
     */
     auto decrypt(const std::string& data, const std::string& key) -> std::string;
     /**
+    @brief Decrypts the provided data in place using the specified key.
+    @param data The data to be decrypted.
+    @param key The decryption key.
+    */
+    void decrypt(std::span<std::byte> data, std::string_view key);
+    /**
+    @brief Decrypts the provided data into a separate buffer using the specified key.
+    @param source The data to be decrypted.
+    @param destination The buffer receiving the decrypted data. Must be at least as large as the source.
+    @param key The decryption key.
+    @param offset Position of the source within the stream, so a file can be decrypted in independent pieces.
+    */
+    void decrypt(std::span<const std::byte> source, std::span<std::byte> destination, std::string_view key,
+                 std::size_t offset = 0);
+    /**
+    @brief Encrypts the provided data in place as if it started at the given offset of a longer stream.
+    Data encrypted at an offset can be decrypted in pieces of any size, as long as each piece uses its own offset.
+    @param data The data to be encrypted.
+    @param key The encryption key.
+    @param offset Position of the data within the stream.
+    */
+    void encrypt(std::span<std::byte> data, std::string_view key, std::size_t offset);
+    /**
+    @brief Decrypts the provided data in place as if it started at the given offset of a longer stream.
+    @param data The data to be decrypted.
+    @param key The decryption key.
+    @param offset Position of the data within the stream.
+    */
+    void decrypt(std::span<std::byte> data, std::string_view key, std::size_t offset);
+    /**
+    @brief Encrypts the provided data in place with a cipher engine.
+    @param data The data to be encrypted.
+    @param engine The engine holding the key.
+    @param offset Position of the data within the stream.
+    */
+    void encrypt(std::span<std::byte> data, const CipherEngine& engine, std::size_t offset = 0);
+    /**
+    @brief Decrypts the provided data into a separate buffer, or in place, with a cipher engine.
+    @param source The data to be decrypted.
+    @param destination The buffer receiving the decrypted data. Must be at least as large as the source.
+    @param engine The engine holding the key.
+    @param offset Position of the source within the stream, so a file can be decrypted in independent pieces.
+    */
+    void decrypt(std::span<const std::byte> source, std::span<std::byte> destination, const CipherEngine& engine,
+                 std::size_t offset = 0);
+    /**
     @brief Applies the XOR operation between the data and the key.
     @param data The data to be XORed.
     @param key The XOR key.
     @return The result of the XOR operation as a string.
     */
     std::string apply_xor(const std::string& data, const std::string& key);
+    /**
+    @brief Applies the XOR operation between the data and the repeating key in place, without allocating.
+    @param data The data to be XORed.
+    @param key The XOR key.
+    */
+    void apply_xor(std::span<std::byte> data, std::string_view key);
+    /**
+    @brief Applies the XOR operation in place using a specific kernel.
+    @param data The data to be XORed.
+    @param key The XOR key.
+    @param kernel The kernel to use. Must be supported by the CPU.
+    */
+    void apply_xor(std::span<std::byte> data, std::string_view key, Kernel kernel);
+    /**
+    @brief Applies the XOR operation between the source and the repeating key, storing the result in the destination.
+    @param source The data to be XORed.
+    @param destination The buffer receiving the result. Must be at least as large as the source and either
+     the same buffer as the source or not overlapping it.
+    @param key The XOR key.
+    @param offset Position of the source within the stream, which decides the key byte the XOR starts with.
+    */
+    void apply_xor(std::span<const std::byte> source, std::span<std::byte> destination, std::string_view key,
+                   std::size_t offset = 0);
+    /**
+    @brief Applies the XOR operation between the source and the repeating key using a specific kernel.
+    @param source The data to be XORed.
+    @param destination The buffer receiving the result.
+    @param key The XOR key.
+    @param kernel The kernel to use. Must be supported by the CPU.
+    @param offset Position of the source within the stream, which decides the key byte the XOR starts with.
+    */
+    void apply_xor(std::span<const std::byte> source, std::span<std::byte> destination, std::string_view key,
+                   Kernel kernel, std::size_t offset = 0);
+    /**
+    @brief Checks if the CPU can run the given kernel.
+    @param kernel The kernel to check.
+    @return True if the kernel is supported, false otherwise.
+    */
+    static bool kernelSupported(Kernel kernel);
+    /**
+    @brief Retrieves the fastest kernel supported by the CPU.
+    @return The kernel used by apply_xor.
+    */
+    static Kernel bestKernel();
 };
 
 
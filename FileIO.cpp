@@ -0,0 +1,57 @@
+#include "FileIO.h"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+    /**
+     * Most bytes passed to one read or write call. It fits the unsigned count _read and _write take on Windows, and
+     * is never 0 while data remains, which a count cut down to 32 bits could be.
+     */
+    constexpr std::size_t maxChunk = std::size_t(1) << 30;
+}
+
+void FileIO::throwLastError(const std::string &what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+void FileIO::writeAll(int fd, std::string_view data, const std::string &fileName) {
+    while (!data.empty()) {
+        auto written = ::write(fd, data.data(), static_cast<unsigned>(std::min(data.size(), maxChunk)));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throwLastError("Failed to write " + fileName);
+        }
+        data.remove_prefix(written);
+    }
+}
+
+std::size_t FileIO::readAll(int fd, char *buffer, std::size_t size) {
+    std::size_t total = 0;
+    while (total < size) {
+        auto count = ::read(fd, buffer + total, static_cast<unsigned>(std::min(size - total, maxChunk)));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        total += count;
+    }
+    return total;
+}
+
+void FileIO::syncFile(int fd, const std::string &fileName) {
+#ifdef _WIN32
+    if (::_commit(fd) != 0) throwLastError("Failed to flush " + fileName);
+#else
+    if (::fsync(fd) != 0) throwLastError("Failed to flush " + fileName);
+#endif
+}
+
+void FileIO::syncDirectory(const std::string &fileName) {
+#ifndef _WIN32
+    auto directory = std::filesystem::path(fileName).parent_path();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+#endif
+}
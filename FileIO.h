@@ -0,0 +1,58 @@
+#ifndef PASSWORDMANAGER_FILEIO_H
+#define PASSWORDMANAGER_FILEIO_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/**
+* @brief Low level file helpers shared by the classes that store data on disk.
+* They work on raw file descriptors so data can be flushed to the disk, and throw std::system_error on failure.
+*/
+namespace FileIO {
+    /**
+    @brief Throws a std::system_error describing the last failed system call.
+    @param what Description of the failed operation.
+    */
+    [[noreturn]] void throwLastError(const std::string& what);
+    /**
+    @brief Writes all of the data to the file descriptor, retrying after partial writes.
+    @param fd The file descriptor to write to.
+    @param data The data to write.
+    @param fileName The name of the file, used in error messages.
+    */
+    void writeAll(int fd, std::string_view data, const std::string& fileName);
+    /**
+    @brief Reads from the file descriptor until the buffer is full or the end of the file is reached.
+    @param fd The file descriptor to read from.
+    @param buffer The buffer to read into.
+    @param size The size of the buffer.
+    @return The number of bytes read.
+    */
+    std::size_t readAll(int fd, char* buffer, std::size_t size);
+    /**
+    @brief Flushes the data written to the file descriptor to the disk.
+    @param fd The file descriptor to flush.
+    @param fileName The name of the file, used in error messages.
+    */
+    void syncFile(int fd, const std::string& fileName);
+    /**
+    @brief Flushes the directory entry of a created or renamed file so the change itself survives a crash.
+    @param fileName The name of the file whose directory is flushed.
+    */
+    void syncDirectory(const std::string& fileName);
+}
+
+#endif //PASSWORDMANAGER_FILEIO_H
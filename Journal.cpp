@@ -0,0 +1,186 @@
+#include "Journal.h"
+#include "FileEncryptor.h"
+#include "FileIO.h"
+#include "Stats.h"
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+
+using namespace FileIO;
+
+namespace {
+    /**
+     * Marks the start of a journal file.
+     */
+    constexpr std::string_view magic = "PMJ2";
+    /**
+     * Marks the start of a journal file written before the cipher engines existed, whose records are XORed with
+     * the password.
+     */
+    constexpr std::string_view legacyMagic = "PMJ1";
+
+    void putU32(string& out, std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) out += static_cast<char>(value >> (8 * i) & 0xFF);
+    }
+
+    std::uint32_t getU32(std::string_view in, std::size_t pos) {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+        return value;
+    }
+
+    /**
+    @brief Computes the FNV-1a hash of the data, used to detect records that were only partially written.
+    */
+    std::uint32_t checksum(std::string_view data) {
+        std::uint32_t hash = 2166136261u;
+        for (char c : data) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash;
+    }
+}
+
+Journal::Journal(const string &vaultFileName, const string &key) : fileName(vaultFileName + ".journal"), key(key) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(fileName, error);
+    fileSize = error ? 0 : size;
+}
+
+bool Journal::exists() const {
+    return std::filesystem::exists(fileName);
+}
+
+std::size_t Journal::size() const {
+    return fileSize + pending.size();
+}
+
+bool Journal::hasPending() const {
+    return !pending.empty();
+}
+
+void Journal::record(Operation operation, std::initializer_list<std::string_view> fields) {
+    string payload;
+    payload += static_cast<char>(operation);
+    payload += static_cast<char>(fields.size());
+    for (auto field : fields) {
+        putU32(payload, field.size());
+        payload += field;
+    }
+    putU32(pending, payload.size());
+    putU32(pending, checksum(payload));
+    pending += payload;
+}
+
+void Journal::flush(std::string_view vaultIdentity) {
+    append(vaultIdentity, pending);
+    pending.clear();
+}
+
+string Journal::takePending() {
+    return std::exchange(pending, string());
+}
+
+void Journal::append(std::string_view vaultIdentity, std::string_view records) {
+    if (records.empty()) return;
+    STATS_TIMER(timer, "Journal::flush");
+    STATS_BYTES(timer, records.size());
+    if (fileSize != 0 && !engine) {
+        // A journal this object did not create: its keystream is unknown, so it is started over.
+        std::error_code error;
+        std::filesystem::remove(fileName, error);
+    }
+    int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_BINARY, 0666);
+    if (fd < 0) throwLastError("Failed to open " + fileName);
+    auto offset = ::lseek(fd, 0, SEEK_END);
+    string data;
+    if (offset == 0) {
+        auto params = CipherParams::generate();
+        data += magic;
+        putU32(data, vaultIdentity.size());
+        data += vaultIdentity;
+        params.appendTo(data);
+        engine = CipherEngine::create(params, key);
+    }
+    auto recordsStart = data.size();
+    data += records;
+    auto fe = FileEncryptor();
+    fe.encrypt(std::as_writable_bytes(std::span(data)).subspan(recordsStart), *engine, offset + recordsStart);
+    try {
+        writeAll(fd, data, fileName);
+        syncFile(fd, fileName);
+    } catch (...) {
+        // Drop the partially written records so later appends stay readable.
+#ifndef _WIN32
+        (void) ::ftruncate(fd, offset);
+#endif
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (offset == 0) syncDirectory(fileName);
+    fileSize = offset + data.size();
+}
+
+auto Journal::read(std::string_view vaultIdentity) const -> vector<Record> {
+    vector<Record> records;
+    int fd = ::open(fileName.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0) return records;
+    auto size = ::lseek(fd, 0, SEEK_END);
+    string data(size > 0 ? size : 0, '\0');
+    if (::lseek(fd, 0, SEEK_SET) == 0) data.resize(readAll(fd, data.data(), data.size()));
+    ::close(fd);
+
+    auto headerSize = magic.size() + 4 + vaultIdentity.size();
+    if (data.size() < headerSize || getU32(data, magic.size()) != vaultIdentity.size() ||
+        std::string_view(data).substr(magic.size() + 4, vaultIdentity.size()) != vaultIdentity) {
+        return records;
+    }
+    std::optional<CipherParams> params;
+    auto fileMagic = std::string_view(data).substr(0, magic.size());
+    if (fileMagic == legacyMagic) {
+        params = CipherParams{Cipher::Xor};
+    } else if (fileMagic == magic) {
+        params = CipherParams::read(std::as_bytes(std::span(data)).subspan(headerSize));
+        headerSize += CipherParams::storedSize;
+    }
+    if (!params) return records;
+    auto fe = FileEncryptor();
+    auto bytes = std::as_writable_bytes(std::span(data)).subspan(headerSize);
+    fe.decrypt(bytes, bytes, *CipherEngine::create(*params, key), headerSize);
+
+    std::string_view view = data;
+    std::size_t pos = headerSize;
+    while (view.size() - pos >= 8) {
+        auto payloadSize = getU32(view, pos);
+        if (payloadSize < 2 || payloadSize > view.size() - pos - 8) break;
+        auto payload = view.substr(pos + 8, payloadSize);
+        if (checksum(payload) != getU32(view, pos + 4)) break;
+        Record record{static_cast<Operation>(payload[0]), {}};
+        auto count = static_cast<unsigned char>(payload[1]);
+        std::size_t fieldPos = 2;
+        for (int i = 0; i < count && payload.size() - fieldPos >= 4; ++i) {
+            auto fieldSize = getU32(payload, fieldPos);
+            if (fieldSize > payload.size() - fieldPos - 4) break;
+            record.fields.emplace_back(payload.substr(fieldPos + 4, fieldSize));
+            fieldPos += 4 + fieldSize;
+        }
+        if (record.fields.size() != count) break;
+        records.push_back(std::move(record));
+        pos += 8 + payloadSize;
+    }
+    return records;
+}
+
+void Journal::clear() {
+    removeFile();
+    pending.clear();
+}
+
+void Journal::removeFile() {
+    std::error_code error;
+    std::filesystem::remove(fileName, error);
+    fileSize = 0;
+    engine.reset();
+}
@@ -0,0 +1,130 @@
+#ifndef PASSWORDMANAGER_JOURNAL_H
+#define PASSWORDMANAGER_JOURNAL_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CipherEngine.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Class representing the write-ahead journal of a password list.
+* Instead of rewriting the whole vault after every change, each change is recorded as a small encrypted record
+* appended to a journal file next to the vault. The journal starts with the identity of the vault version it
+* applies to, so a journal left behind by a crash is replayed only on top of the vault it was written for,
+* followed by the cipher parameters the records are encrypted with.
+* Record format (encrypted at their position in the file):
+* payload size (4 bytes), payload checksum (4 bytes), operation (1 byte), field count (1 byte),
+* and every field as its size (4 bytes) followed by its bytes.
+*/
+class Journal {
+public:
+    /**
+     * Operations that can be recorded in the journal.
+     */
+    enum class Operation : std::uint8_t {
+        AddCategory = 1, RemoveCategory, AddEntry, RemoveEntry, UpdateEntry, MoveEntry
+    };
+    /**
+     * A single change read back from the journal.
+     */
+    struct Record {
+        Operation operation;
+        vector<string> fields;
+    };
+    /**
+     * Size above which the journal should be compacted into the vault.
+     */
+    static constexpr std::size_t maxSize = 1 << 20;
+private:
+    /**
+     * The name of the journal file.
+     */
+    string fileName;
+    /**
+     * The key used to encrypt the records.
+     */
+    string key;
+    /**
+     * Encoded records that have not been appended to the file yet.
+     */
+    string pending;
+    /**
+     * Size of the journal file, or 0 if it does not exist.
+     */
+    std::size_t fileSize;
+    /**
+     * The engine the records of the journal file are encrypted with, created along with the file.
+     */
+    std::unique_ptr<CipherEngine> engine;
+public:
+    /**
+    @brief Constructs a Journal object for the given vault.
+    @param vaultFileName The name of the vault file. The journal is stored next to it.
+    @param key The key used to encrypt the records.
+    */
+    Journal(const string& vaultFileName, const string& key);
+    /**
+    @brief Checks if the journal file exists.
+    @return True if the file exists, false otherwise.
+    */
+    bool exists() const;
+    /**
+    @brief Retrieves the size of the journal, including the records that have not been appended yet.
+    @return The size of the journal in bytes.
+    */
+    std::size_t size() const;
+    /**
+    @brief Checks if there are records that have not been appended to the file yet.
+    @return True if there are pending records, false otherwise.
+    */
+    bool hasPending() const;
+    /**
+    @brief Records a change. The record is kept in memory until flush() is called.
+    @param operation The operation to record.
+    @param fields The fields describing the change.
+    */
+    void record(Operation operation, std::initializer_list<std::string_view> fields);
+    /**
+    @brief Appends the pending records to the journal file and flushes them to the disk.
+     The file is created if it does not exist.
+    @param vaultIdentity The identity of the vault the journal applies to, written when the file is created.
+    @throws std::system_error If the records could not be written.
+    */
+    void flush(std::string_view vaultIdentity);
+    /**
+    @brief Takes the pending records out of the journal, so they can be appended by append() while new changes
+     are recorded.
+    @return The encoded records.
+    */
+    string takePending();
+    /**
+    @brief Appends records taken with takePending() to the journal file and flushes them to the disk, in the way of
+     flush(). Only the file is touched, so new changes may be recorded meanwhile.
+    @param vaultIdentity The identity of the vault the journal applies to, written when the file is created.
+    @param records The encoded records.
+    @throws std::system_error If the records could not be written. They are not kept.
+    */
+    void append(std::string_view vaultIdentity, std::string_view records);
+    /**
+    @brief Reads the records stored in the journal file. Reading stops at the first incomplete or damaged record.
+    @param vaultIdentity The identity of the vault the records have to apply to.
+    @return The records, or an empty vector if the file is missing or was written for a different vault version.
+    */
+    vector<Record> read(std::string_view vaultIdentity) const;
+    /**
+    @brief Removes the journal file and drops the pending records.
+    */
+    void clear();
+    /**
+    @brief Removes the journal file, keeping the pending records for the next journal.
+    */
+    void removeFile();
+};
+
+
+#endif //PASSWORDMANAGER_JOURNAL_H
@@ -0,0 +1,130 @@
+#include "LookupClient.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FileIO.h"
+#include "LookupServer.h"
+
+LookupClient::LookupClient(string socketPath) : socketPath(std::move(socketPath)) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->socketPath.empty() || this->socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), "Invalid socket file " + this->socketPath);
+    }
+    std::copy(this->socketPath.begin(), this->socketPath.end(), address.sun_path);
+    socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket < 0) FileIO::throwLastError("Failed to create a socket");
+    if (::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        ::close(socket);
+        throw std::system_error(error, std::generic_category(), "Failed to connect to " + this->socketPath);
+    }
+    // The server checks who connects, and the client checks who answers, so no other user can pose as the server.
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0 || credentials.uid != ::geteuid()) {
+        ::close(socket);
+        throw std::system_error(EACCES, std::generic_category(), this->socketPath + " belongs to another user");
+    }
+}
+
+LookupClient::~LookupClient() {
+    ::close(socket);
+}
+
+string LookupClient::request(std::string_view request) {
+    string frame;
+    LookupServer::appendFrame(frame, request);
+    std::string_view rest = frame;
+    while (!rest.empty()) {
+        auto count = ::send(socket, rest.data(), rest.size(), MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            FileIO::throwLastError("Failed to send to " + socketPath);
+        }
+        rest.remove_prefix(static_cast<std::size_t>(count));
+    }
+    string response(LookupServer::headerSize, '\0');
+    auto receive = [&](std::size_t from) {
+        if (FileIO::readAll(socket, response.data() + from, response.size() - from) != response.size() - from) {
+            throw std::system_error(ECONNRESET, std::generic_category(), socketPath + " closed the connection");
+        }
+    };
+    receive(0);
+    response.resize(LookupServer::headerSize + *LookupServer::frameLength(response));
+    receive(LookupServer::headerSize);
+    response.erase(0, LookupServer::headerSize);
+    return response;
+}
+
+bool LookupClient::succeeded(std::string_view response) {
+    return response.starts_with("{\"ok\":true");
+}
+
+LookupClient::LoadReport LookupClient::loadTest(const string &socketPath, const vector<string> &requests,
+                                                std::size_t connections, std::size_t requestsPerConnection) {
+    vector<LoadReport> parts(connections);
+    vector<std::exception_ptr> errors(connections);
+    vector<std::unique_ptr<LookupClient>> clients(connections);
+    // Every connection is open before the clock starts.
+    for (auto& client : clients) client = std::make_unique<LookupClient>(socketPath);
+    auto start = std::chrono::steady_clock::now();
+    vector<std::thread> threads;
+    for (std::size_t c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c] {
+            try {
+                auto& part = parts[c];
+                part.latencies.reserve(requestsPerConnection);
+                for (std::size_t i = 0; i < requestsPerConnection; ++i) {
+                    auto sent = std::chrono::steady_clock::now();
+                    auto response = clients[c]->request(requests[(c * requestsPerConnection + i) % requests.size()]);
+                    part.latencies.push_back(
+                            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - sent).count());
+                    ++part.requests;
+                    if (!succeeded(response)) ++part.failed;
+                }
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    LoadReport report;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    for (auto& part : parts) {
+        report.requests += part.requests;
+        report.failed += part.failed;
+        report.latencies.insert(report.latencies.end(), part.latencies.begin(), part.latencies.end());
+    }
+    return report;
+}
+
+double LookupClient::LoadReport::requestsPerSecond() const {
+    return seconds > 0 ? static_cast<double>(requests) / seconds : 0;
+}
+
+double LookupClient::LoadReport::latency(double fraction) const {
+    if (latencies.empty()) return 0;
+    auto sorted = latencies;
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(std::clamp<std::size_t>(rank, 1, sorted.size()) - 1);
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PASSWORDMANAGER_LOOKUPCLIENT_H
+#define PASSWORDMANAGER_LOOKUPCLIENT_H
+
+#ifdef __linux__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string, std::vector;
+
+/**
+* @brief Class sending requests to a LookupServer, one at a time, over a connection of its own.
+*/
+class LookupClient {
+    string socketPath;
+    int socket = -1;
+public:
+    /**
+    * @brief The outcome of a load test.
+    */
+    struct LoadReport {
+        /**
+         * Number of requests sent, and number of them answered with an error.
+         */
+        std::size_t requests = 0, failed = 0;
+        /**
+         * Time the whole test took, in seconds.
+         */
+        double seconds = 0;
+        /**
+         * Time every request took until its response was read, in nanoseconds, in no particular order.
+         */
+        vector<double> latencies;
+        /**
+        @brief Computes the rate of requests.
+        @return The number of requests answered per second.
+        */
+        double requestsPerSecond() const;
+        /**
+        @brief Computes a percentile of the latencies.
+        @param fraction The fraction of requests that took at most the returned time, for example 0.99.
+        @return The latency in nanoseconds, or 0 if no request was sent.
+        */
+        double latency(double fraction) const;
+    };
+    /**
+    @brief Constructs a LookupClient connected to a server.
+    @param socketPath The socket file of the server.
+    @throws std::system_error If the server cannot be reached, or runs as another user.
+    */
+    explicit LookupClient(string socketPath);
+    ~LookupClient();
+    LookupClient(const LookupClient&) = delete;
+    LookupClient& operator=(const LookupClient&) = delete;
+    /**
+    @brief Sends a request and waits for its response.
+    @param request The command and its arguments, separated by tabs, see LookupServer.
+    @return The JSON response.
+    @throws std::system_error If the connection fails or the server closes it.
+    */
+    string request(std::string_view request);
+    /**
+    @brief Checks if a response reports success.
+    @param response The response.
+    @return True if the request succeeded, false otherwise.
+    */
+    static bool succeeded(std::string_view response);
+    /**
+    @brief Measures how many requests a server answers: every connection sends requests one after the other on a
+     thread of its own, going through the given requests in turn from a different starting point.
+    @param socketPath The socket file of the server.
+    @param requests The requests to send. Must not be empty.
+    @param connections The number of connections sending requests at once.
+    @param requestsPerConnection The number of requests every connection sends.
+    @return The report of the test.
+    @throws std::system_error If a connection fails.
+    */
+    static LoadReport loadTest(const string& socketPath, const vector<string>& requests, std::size_t connections,
+                               std::size_t requestsPerConnection);
+};
+
+#endif
+
+#endif //PASSWORDMANAGER_LOOKUPCLIENT_H
@@ -0,0 +1,321 @@
+#include "LookupServer.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FileIO.h"
+#include "Stats.h"
+
+namespace {
+    /**
+     * The commands served, all of which only read the password list.
+     */
+    constexpr std::string_view servedCommands[] = {"get", "find", "categories"};
+    constexpr int handledSignals[] = {SIGINT, SIGTERM, SIGHUP};
+    /**
+     * The event file the signal handler writes to, set by stopOnSignals().
+     */
+    int signalEvent = -1;
+
+    void onSignal(int) {
+        // Writing to an event file is one of the few things a signal handler may do.
+        std::uint64_t one = 1;
+        (void) ::write(signalEvent, &one, sizeof(one));
+    }
+
+    /**
+    @brief Builds the address of a socket file.
+    @throws std::system_error If the file name is too long for a socket address.
+    */
+    sockaddr_un socketAddress(const string& socketPath) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::system_error(ENAMETOOLONG, std::generic_category(), "Invalid socket file " + socketPath);
+        }
+        std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+        return address;
+    }
+
+    /**
+    @brief Removes a socket file left by a server that stopped without removing it.
+    @throws std::system_error If the file is not a socket, or a server still listens on it.
+    */
+    void removeStale(const string& socketPath, const sockaddr_un& address) {
+        struct stat status{};
+        if (::lstat(socketPath.c_str(), &status) != 0) {
+            if (errno == ENOENT) return;
+            FileIO::throwLastError("Failed to check " + socketPath);
+        }
+        if (!S_ISSOCK(status.st_mode)) {
+            throw std::system_error(EEXIST, std::generic_category(), socketPath + " exists and is not a socket");
+        }
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) FileIO::throwLastError("Failed to create a socket");
+        int connected = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        int error = errno;
+        ::close(probe);
+        if (connected == 0) {
+            throw std::system_error(EADDRINUSE, std::generic_category(), "A server already listens on " + socketPath);
+        }
+        if (error != ECONNREFUSED) {
+            throw std::system_error(error, std::generic_category(), "Failed to connect to " + socketPath);
+        }
+        if (::unlink(socketPath.c_str()) != 0) FileIO::throwLastError("Failed to remove " + socketPath);
+    }
+}
+
+LookupServer::LookupServer(PasswordList &passwordList, string socketPath)
+        : runner(passwordList), socketPath(std::move(socketPath)) {
+    auto address = socketAddress(this->socketPath);
+    try {
+        removeStale(this->socketPath, address);
+        listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0) FileIO::throwLastError("Failed to create a socket");
+        // The socket file is created only accessible to its owner, with no window in which others could connect.
+        auto mask = ::umask(0177);
+        int result = ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        ::umask(mask);
+        if (result != 0) FileIO::throwLastError("Failed to bind " + this->socketPath);
+        bound = true;
+        if (::listen(listener, SOMAXCONN) != 0) FileIO::throwLastError("Failed to listen on " + this->socketPath);
+        epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll < 0) FileIO::throwLastError("Failed to create an epoll instance");
+        stopEvent = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stopEvent < 0) FileIO::throwLastError("Failed to create an event file");
+        for (int fd : {listener, stopEvent}) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) FileIO::throwLastError("Failed to watch a socket");
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+LookupServer::~LookupServer() {
+    if (signalEvent == stopEvent && stopEvent >= 0) {
+        for (int signal : handledSignals) std::signal(signal, SIG_DFL);
+        signalEvent = -1;
+    }
+    release();
+}
+
+void LookupServer::release() {
+    for (const auto& [socket, connection] : connections) {
+        ::close(socket);
+    }
+    connections.clear();
+    for (int* fd : {&listener, &epoll, &stopEvent}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+    if (bound) ::unlink(socketPath.c_str());
+    bound = false;
+}
+
+void LookupServer::run() {
+    std::array<epoll_event, 64> events{};
+    while (true) {
+        int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            FileIO::throwLastError("Failed to wait for clients");
+        }
+        bool stopping = false;
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            auto flags = events[i].events;
+            if (fd == stopEvent) {
+                std::uint64_t value;
+                (void) ::read(stopEvent, &value, sizeof(value));
+                stopping = true;
+                continue;
+            }
+            if (fd == listener) {
+                acceptAll();
+                continue;
+            }
+            auto connection = connections.find(fd);
+            if (connection == connections.end()) continue;
+            bool open = (flags & EPOLLERR) == 0;
+            if (open && (flags & EPOLLIN) != 0) open = receive(fd, connection->second);
+            if (open && (flags & EPOLLOUT) != 0) open = send(fd, connection->second);
+            // A hang up without data to read means the client is gone, even if responses are left to send.
+            if (open && (flags & EPOLLHUP) != 0 && (flags & EPOLLIN) == 0) open = false;
+            if (!open) close(fd);
+        }
+        if (stopping) return;
+    }
+}
+
+void LookupServer::stop() {
+    std::uint64_t one = 1;
+    (void) ::write(stopEvent, &one, sizeof(one));
+}
+
+void LookupServer::stopOnSignals() {
+    signalEvent = stopEvent;
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    for (int signal : handledSignals) sigaction(signal, &action, nullptr);
+}
+
+std::uint64_t LookupServer::requestCount() const {
+    return requests.load(std::memory_order_relaxed);
+}
+
+void LookupServer::acceptAll() {
+    while (true) {
+        int socket = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            // Nothing is pending anymore, or no more files can be opened until a client leaves.
+            return;
+        }
+        ucred credentials{};
+        socklen_t size = sizeof(credentials);
+        if (::getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0 ||
+            credentials.uid != ::geteuid()) {
+            ::close(socket);
+            continue;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        if (::epoll_ctl(epoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+            ::close(socket);
+            continue;
+        }
+        connections.try_emplace(socket);
+    }
+}
+
+bool LookupServer::receive(int socket, Connection &connection) {
+    char buffer[16 * 1024];
+    bool ended = false;
+    while (true) {
+        auto count = ::read(socket, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        if (count == 0) {
+            ended = true;
+            break;
+        }
+        connection.input.append(buffer, static_cast<std::size_t>(count));
+        if (connection.input.size() > maxRequestSize + headerSize) break;
+    }
+    std::string_view input = connection.input;
+    bool answered = false;
+    while (auto length = frameLength(input)) {
+        if (*length > maxRequestSize) return false;
+        if (input.size() < headerSize + *length) break;
+        // The length is written once the response is complete.
+        auto start = connection.output.size();
+        connection.output.append(headerSize, '\0');
+        handle(input.substr(headerSize, *length), connection.output);
+        auto response = connection.output.size() - start - headerSize;
+        for (std::size_t i = 0; i < headerSize; ++i) {
+            connection.output[start + i] = static_cast<char>(response >> (8 * (headerSize - 1 - i)) & 0xFF);
+        }
+        input.remove_prefix(headerSize + *length);
+        answered = true;
+    }
+    connection.input.erase(0, connection.input.size() - input.size());
+    if (answered && !send(socket, connection)) return false;
+    // A client that stopped sending still gets the responses to its complete requests.
+    return !ended || connection.sent < connection.output.size();
+}
+
+bool LookupServer::send(int socket, Connection &connection) {
+    while (connection.sent < connection.output.size()) {
+        auto count = ::send(socket, connection.output.data() + connection.sent,
+                            connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        connection.sent += static_cast<std::size_t>(count);
+    }
+    bool pending = connection.sent < connection.output.size();
+    if (!pending) {
+        connection.output.clear();
+        connection.sent = 0;
+    }
+    // While responses wait for the client to read them, no more requests are read, which bounds the output.
+    epoll_event event{};
+    event.events = pending ? EPOLLOUT : EPOLLIN;
+    event.data.fd = socket;
+    return ::epoll_ctl(epoll, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+void LookupServer::close(int socket) {
+    ::epoll_ctl(epoll, EPOLL_CTL_DEL, socket, nullptr);
+    ::close(socket);
+    connections.erase(socket);
+}
+
+void LookupServer::handle(std::string_view request, string &response) {
+    STATS_TIMER(timer, "LookupServer::handle");
+    vector<std::string_view> arguments;
+    BatchRunner::split(request, arguments);
+    string members;
+    try {
+        if (std::find(std::begin(servedCommands), std::end(servedCommands), arguments[0]) ==
+            std::end(servedCommands)) {
+            throw std::invalid_argument("Unknown command " + string(arguments[0]));
+        }
+        runner.execute(arguments, members);
+        response += "{\"ok\":true" + members + "}";
+    } catch (const std::logic_error& e) {
+        response += "{\"ok\":false,\"error\":";
+        EntryWriter::appendJson(response, e.what());
+        response += '}';
+    }
+    requests.fetch_add(1, std::memory_order_relaxed);
+}
+
+string LookupServer::defaultSocketPath() {
+    auto runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime != nullptr && *runtime != '\0') return string(runtime) + "/passwordmanager.sock";
+    return "/tmp/passwordmanager-" + std::to_string(::geteuid()) + ".sock";
+}
+
+void LookupServer::appendFrame(string &out, std::string_view payload) {
+    for (std::size_t i = 0; i < headerSize; ++i) {
+        out += static_cast<char>(payload.size() >> (8 * (headerSize - 1 - i)) & 0xFF);
+    }
+    out += payload;
+}
+
+std::optional<std::size_t> LookupServer::frameLength(std::string_view data) {
+    if (data.size() < headerSize) return std::nullopt;
+    std::size_t length = 0;
+    for (std::size_t i = 0; i < headerSize; ++i) {
+        length = length << 8 | static_cast<unsigned char>(data[i]);
+    }
+    return length;
+}
+
+#endif
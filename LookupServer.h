@@ -0,0 +1,161 @@
+#ifndef PASSWORDMANAGER_LOOKUPSERVER_H
+#define PASSWORDMANAGER_LOOKUPSERVER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "BatchRunner.h"
+#include "PasswordList.h"
+
+using std::string;
+
+/**
+* @brief Class serving lookups in an unlocked password list over a Unix domain socket, so scripts can read
+* credentials without unlocking the vault for every lookup.
+* Every message is a frame: its length as 4 bytes in big-endian order, followed by that many bytes. A request holds
+* one command in the syntax of BatchRunner, its arguments separated by tabs; only the commands that read the list
+* are served:
+*
+*     get <category> <name>
+*     find <name|login|website> <value>
+*     categories
+*
+* The response holds the JSON object BatchRunner writes for the command, without the line number:
+* {"ok":true,"entries":[...]}, {"ok":true,"categories":[...]} or {"ok":false,"error":"..."}. A client may send
+* several requests without waiting; the responses come back in order. A connection sending a frame longer than
+* maxRequestSize is closed.
+* Only the user running the server may connect: the socket file is only readable and writable by its owner, and
+* connections from processes of other users are refused after checking their credentials.
+* All connections are served by one thread with an epoll event loop. The password list is the one unlocked when the
+* server started; changes saved to the vault afterwards are only served once the server is restarted.
+*/
+class LookupServer {
+public:
+    /**
+     * Longest request a client may send, in bytes.
+     */
+    static constexpr std::size_t maxRequestSize = 64 * 1024;
+    /**
+     * Number of bytes of the length in front of every frame.
+     */
+    static constexpr std::size_t headerSize = 4;
+private:
+    /**
+     * A client connection, with the bytes received and not handled yet and the bytes to send.
+     */
+    struct Connection {
+        string input;
+        string output;
+        /**
+         * Number of bytes of the output already sent.
+         */
+        std::size_t sent = 0;
+    };
+    BatchRunner runner;
+    string socketPath;
+    int listener = -1;
+    /**
+     * Whether the socket file was created by this server, so it is removed when the server ends.
+     */
+    bool bound = false;
+    int epoll = -1;
+    /**
+     * Event file written to by stop(), which may be called from another thread or a signal handler.
+     */
+    int stopEvent = -1;
+    /**
+     * The open connections, by socket.
+     */
+    std::unordered_map<int, Connection> connections;
+    std::atomic<std::uint64_t> requests = 0;
+    /**
+    @brief Accepts the pending connections, refusing the ones of other users.
+    */
+    void acceptAll();
+    /**
+    @brief Reads what a client sent and answers the complete requests.
+    @return False if the connection has to be closed.
+    */
+    bool receive(int socket, Connection& connection);
+    /**
+    @brief Sends as much of the pending output of a connection as the socket takes, and waits for the socket to
+     take more if some is left.
+    @return False if the connection has to be closed.
+    */
+    bool send(int socket, Connection& connection);
+    void close(int socket);
+    /**
+    @brief Closes every socket and removes the socket file if it was created.
+    */
+    void release();
+    /**
+    @brief Answers a request.
+    @param request The request, without its length.
+    @param response The string the response is appended to, without its length.
+    */
+    void handle(std::string_view request, string& response);
+public:
+    /**
+    @brief Constructs a LookupServer listening on a socket. A socket file left by a server that is not running
+     anymore is replaced.
+    @param passwordList The password list to serve. Must outlive the server.
+    @param socketPath The file of the socket.
+    @throws std::system_error If the socket cannot be created, or the file exists and is not the socket of a server
+     that stopped.
+    */
+    LookupServer(PasswordList& passwordList, string socketPath);
+    /**
+    @brief Closes the connections and removes the socket file.
+    */
+    ~LookupServer();
+    LookupServer(const LookupServer&) = delete;
+    LookupServer& operator=(const LookupServer&) = delete;
+    /**
+    @brief Serves the clients until stop() is called.
+    @throws std::system_error If waiting for events fails.
+    */
+    void run();
+    /**
+    @brief Makes run() return once the events it is handling are done. Can be called from any thread and from a
+     signal handler.
+    */
+    void stop();
+    /**
+    @brief Makes SIGINT, SIGTERM and SIGHUP stop the server rather than end the program. Only one server of the
+     program can do so.
+    */
+    void stopOnSignals();
+    /**
+    @brief Retrieves the number of requests answered so far. Can be called from any thread.
+    @return The number of requests.
+    */
+    std::uint64_t requestCount() const;
+    /**
+    @brief Chooses the socket file used when none is given: passwordmanager.sock in $XDG_RUNTIME_DIR, a directory
+     only its user can enter, or else a file in /tmp named after the user id.
+    @return The file name.
+    */
+    static string defaultSocketPath();
+    /**
+    @brief Appends a frame to a string.
+    @param out The string to append to.
+    @param payload The contents of the frame.
+    */
+    static void appendFrame(string& out, std::string_view payload);
+    /**
+    @brief Reads the length of the frame at the beginning of some data.
+    @param data The data.
+    @return The length of the contents of the frame, or an empty optional if the data is shorter than headerSize.
+    */
+    static std::optional<std::size_t> frameLength(std::string_view data);
+};
+
+#endif
+
+#endif //PASSWORDMANAGER_LOOKUPSERVER_H
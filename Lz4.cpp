@@ -0,0 +1,129 @@
+#include "Lz4.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    constexpr std::size_t minMatch = 4;
+    /**
+     * The last bytes of the data are always literals.
+     */
+    constexpr std::size_t lastLiterals = 5;
+    /**
+     * No match may start within this many bytes of the end of the data.
+     */
+    constexpr std::size_t matchLimit = 12;
+    constexpr std::size_t maxOffset = 65535;
+    constexpr int hashBits = 13;
+    constexpr std::uint32_t noPosition = UINT32_MAX;
+
+    std::uint32_t load32(const char* data) {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    std::uint32_t hash(std::uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - hashBits);
+    }
+
+    /**
+    @brief Appends the part of a length that does not fit in its 4 bits of the token.
+    */
+    void putLength(string& out, std::size_t length) {
+        for (length -= 15; length >= 255; length -= 255) out += static_cast<char>(255);
+        out += static_cast<char>(length);
+    }
+
+    /**
+    @brief Reads the part of a length that did not fit in its 4 bits of the token.
+    @return False if the input ends first.
+    */
+    bool getLength(std::string_view input, std::size_t& pos, std::size_t& length) {
+        unsigned char byte;
+        do {
+            if (pos >= input.size()) return false;
+            byte = static_cast<unsigned char>(input[pos++]);
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    void putSequence(string& out, std::string_view literals, std::size_t offset, std::size_t matchLength) {
+        auto matchCode = matchLength - minMatch;
+        out += static_cast<char>(std::min<std::size_t>(literals.size(), 15) << 4 |
+                                 std::min<std::size_t>(matchCode, 15));
+        if (literals.size() >= 15) putLength(out, literals.size());
+        out += literals;
+        out += static_cast<char>(offset & 0xFF);
+        out += static_cast<char>(offset >> 8);
+        if (matchCode >= 15) putLength(out, matchCode);
+    }
+}
+
+void Lz4::compress(std::string_view input, string &out) {
+    const char* data = input.data();
+    std::size_t anchor = 0;
+    if (input.size() > matchLimit) {
+        std::array<std::uint32_t, 1 << hashBits> table;
+        table.fill(noPosition);
+        auto limit = input.size() - matchLimit;
+        auto matchEndLimit = input.size() - lastLiterals;
+        std::size_t pos = 0;
+        while (pos < limit) {
+            auto sequence = load32(data + pos);
+            auto& slot = table[hash(sequence)];
+            std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(pos);
+            if (candidate == noPosition || pos - candidate > maxOffset || load32(data + candidate) != sequence) {
+                ++pos;
+                continue;
+            }
+            auto end = pos + minMatch;
+            while (end < matchEndLimit && data[end] == data[candidate + end - pos]) ++end;
+            while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            putSequence(out, input.substr(anchor, pos - anchor), pos - candidate, end - pos);
+            pos = end;
+            anchor = end;
+        }
+    }
+    auto literals = input.substr(anchor);
+    out += static_cast<char>(std::min<std::size_t>(literals.size(), 15) << 4);
+    if (literals.size() >= 15) putLength(out, literals.size());
+    out += literals;
+}
+
+bool Lz4::decompress(std::string_view input, std::span<char> output) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (true) {
+        if (in >= input.size()) return false;
+        auto token = static_cast<unsigned char>(input[in++]);
+        std::size_t literals = token >> 4;
+        if (literals == 15 && !getLength(input, in, literals)) return false;
+        if (literals > input.size() - in || literals > output.size() - out) return false;
+        std::memcpy(output.data() + out, input.data() + in, literals);
+        in += literals;
+        out += literals;
+        // The last sequence has no match.
+        if (in == input.size()) return out == output.size();
+        if (input.size() - in < 2) return false;
+        std::size_t offset = static_cast<unsigned char>(input[in]) | static_cast<unsigned char>(input[in + 1]) << 8;
+        in += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !getLength(input, in, length)) return false;
+        length += minMatch;
+        if (offset == 0 || offset > out || length > output.size() - out) return false;
+        // The match may overlap the bytes it produces, so it is copied byte by byte when it is close.
+        if (offset >= length) {
+            std::memcpy(output.data() + out, output.data() + out - offset, length);
+        } else {
+            for (std::size_t i = 0; i < length; ++i) output[out + i] = output[out + i - offset];
+        }
+        out += length;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef PASSWORDMANAGER_LZ4_H
+#define PASSWORDMANAGER_LZ4_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+using std::string;
+
+/**
+* @brief A self-contained codec for the LZ4 block format.
+* Compressed data is a series of sequences, each made of a token, literals copied as they are and a match: a copy of
+* at least 4 earlier bytes of the output, found up to 65535 bytes back. The compressor finds matches greedily through
+* a hash table of the 4-byte sequences seen so far, which makes it fast rather than thorough; repeated names, logins
+* and website domains are what it is meant to catch.
+*/
+namespace Lz4 {
+    /**
+    @brief Compresses data, appending the result to a string.
+    @param input The data to compress.
+    @param out The string to append the compressed data to.
+    */
+    void compress(std::string_view input, string& out);
+    /**
+    @brief Decompresses data into a buffer of the exact size of the original data.
+    @param input The compressed data.
+    @param output The buffer receiving the data.
+    @return True if the data was decompressed, false if it is malformed or does not fill the buffer exactly.
+    */
+    bool decompress(std::string_view input, std::span<char> output);
+}
+
+
+#endif //PASSWORDMANAGER_LZ4_H
@@ -0,0 +1,80 @@
+#include "PasswordGenerator.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+PasswordGenerator::PasswordGenerator(std::string_view alphabet) {
+    setAlphabet(alphabet);
+    reseed();
+}
+
+PasswordGenerator::~PasswordGenerator() {
+    // The unused bytes would tell the next passwords.
+    buffer.fill(std::byte{0});
+}
+
+string PasswordGenerator::defaultAlphabet() {
+    return string(lowercase) + string(digits) + string(uppercase) + string(symbols);
+}
+
+void PasswordGenerator::reseed() {
+    std::random_device random;
+    std::array<std::byte, 32> key;
+    std::array<std::byte, 12> nonce;
+    for (auto& byte : key) byte = static_cast<std::byte>(random());
+    for (auto& byte : nonce) byte = static_cast<std::byte>(random());
+    stream = std::make_unique<ChaCha20>(key, nonce);
+    key.fill(std::byte{0});
+    streamOffset = 0;
+    position = bufferSize;
+}
+
+void PasswordGenerator::refill() {
+    if (streamOffset >= reseedInterval) reseed();
+    // The keystream is the encryption of zeros.
+    buffer.fill(std::byte{0});
+    stream->apply(buffer, buffer, streamOffset);
+    streamOffset += bufferSize;
+    position = 0;
+}
+
+void PasswordGenerator::setAlphabet(std::string_view alphabet) {
+    std::array<bool, 256> seen{};
+    string unique;
+    for (char c : alphabet) {
+        auto byte = static_cast<unsigned char>(c);
+        if (!seen[byte]) unique += c;
+        seen[byte] = true;
+    }
+    if (unique.empty()) throw std::invalid_argument("The alphabet is empty");
+    characters = std::move(unique);
+    acceptLimit = 256 - 256 % characters.size();
+}
+
+const string &PasswordGenerator::alphabet() const {
+    return characters;
+}
+
+string PasswordGenerator::generate(std::size_t length) {
+    string password;
+    generate(length, 1, password);
+    return password;
+}
+
+void PasswordGenerator::generate(std::size_t length, std::size_t count, string &out) {
+    auto start = out.size();
+    out.resize(start + length * count);
+    char* next = out.data() + start;
+    char* end = out.data() + out.size();
+    const auto size = static_cast<unsigned>(characters.size());
+    while (next != end) {
+        if (position == bufferSize) refill();
+        auto byte = std::to_integer<unsigned>(buffer[position]);
+        buffer[position++] = std::byte{0};
+        if (byte < acceptLimit) *next++ = characters[byte % size];
+    }
+}
+
+double PasswordGenerator::entropyBits(std::size_t length) const {
+    return static_cast<double>(length) * std::log2(static_cast<double>(characters.size()));
+}
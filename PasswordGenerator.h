@@ -0,0 +1,110 @@
+#ifndef PASSWORDMANAGER_PASSWORDGENERATOR_H
+#define PASSWORDMANAGER_PASSWORDGENERATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "ChaCha20.h"
+
+using std::string;
+
+/**
+* @brief Class generating random passwords from an alphabet.
+* The random bytes come from a ChaCha20 keystream under a key drawn from the operating system's random source
+* when the generator is constructed, and drawn again every reseedInterval bytes. Every character of the alphabet is
+* equally likely: a byte is only used if it falls below the largest multiple of the size of the alphabet, and drawn
+* again otherwise, so no character gets the remainder.
+* The keystream is buffered, so a generator must not be used from several threads at once.
+*/
+class PasswordGenerator {
+public:
+    static constexpr std::string_view lowercase = "abcdefghijklmnopqrstuvwxyz";
+    static constexpr std::string_view digits = "0123456789";
+    static constexpr std::string_view uppercase = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static constexpr std::string_view symbols = "!@#$%&";
+    /**
+     * Number of random bytes after which a new key is drawn.
+     */
+    static constexpr std::uint64_t reseedInterval = std::uint64_t(1) << 30;
+private:
+    /**
+     * Number of random bytes produced at a time.
+     */
+    static constexpr std::size_t bufferSize = 4096;
+    std::unique_ptr<ChaCha20> stream;
+    /**
+     * Position of the next block of random bytes within the stream.
+     */
+    std::uint64_t streamOffset = 0;
+    std::array<std::byte, bufferSize> buffer;
+    /**
+     * Position of the next unused byte of the buffer.
+     */
+    std::size_t position = bufferSize;
+    /**
+     * The characters passwords are made of, each appearing once.
+     */
+    string characters;
+    /**
+     * Random bytes from this value up are drawn again.
+     */
+    unsigned acceptLimit = 0;
+    /**
+    @brief Draws a new key and nonce and restarts the stream.
+    */
+    void reseed();
+    /**
+    @brief Fills the buffer with the next random bytes of the stream.
+    */
+    void refill();
+public:
+    /**
+    @brief Constructs a PasswordGenerator, seeding it from the operating system's random source.
+    @param alphabet The characters passwords are made of. Characters appearing more than once count once.
+    @throws std::invalid_argument If the alphabet is empty.
+    */
+    explicit PasswordGenerator(std::string_view alphabet = defaultAlphabet());
+    ~PasswordGenerator();
+    /**
+    @brief Retrieves the alphabet of lowercase letters, digits, uppercase letters and symbols.
+    @return The alphabet.
+    */
+    static string defaultAlphabet();
+    /**
+    @brief Changes the characters passwords are made of.
+    @param alphabet The characters. Characters appearing more than once count once.
+    @throws std::invalid_argument If the alphabet is empty.
+    */
+    void setAlphabet(std::string_view alphabet);
+    /**
+    @brief Retrieves the characters passwords are made of, each appearing once.
+    @return The characters.
+    */
+    const string& alphabet() const;
+    /**
+    @brief Generates a password.
+    @param length The number of characters of the password.
+    @return The password.
+    */
+    string generate(std::size_t length);
+    /**
+    @brief Generates passwords into a single buffer, which is faster than generating them one by one.
+    @param length The number of characters of every password.
+    @param count The number of passwords.
+    @param out The string to append the passwords to, one after the other without separators. Password i starts at
+     the position out had before the call plus i * length.
+    */
+    void generate(std::size_t length, std::size_t count, string& out);
+    /**
+    @brief Estimates the strength of the passwords of a given length, which are drawn uniformly from the alphabet.
+    @param length The number of characters of a password.
+    @return The entropy of a password in bits.
+    */
+    double entropyBits(std::size_t length) const;
+};
+
+
+#endif //PASSWORDMANAGER_PASSWORDGENERATOR_H
@@ -1,56 +1,285 @@
 #include "PasswordList.h"
 #include "FileEncryptor.h"
-#include <fstream>
-#include <chrono>
+#include "VaultHeader.h"
+#include "BinaryVault.h"
+#include <algorithm>
+#include <array>
+#include <memory>
 #include "DecryptionException.h"
+#include "Stats.h"
 
 using std::vector, std::string, std::cout, std::cin;
 
-PasswordList::PasswordList(const string &fileName, const string &password) : fileName(fileName), password(password) {
-    auto file = std::ifstream(fileName, std::ios::binary);
-    if(file.is_open()) {
-        string content = read();
-        write(content);
-        try{
-            decryptData(read());
-        } catch(DecryptionException& e){
-            throw DecryptionException();
+PasswordList::PasswordList(const string &fileName, const string &password, ThreadPool &pool,
+                           PasswordStorage storage)
+        : fileName(fileName), vaultFile(fileName), journal(fileName, password), password(password), pool(pool),
+          storage(storage) {
+    bool exists = vaultFile.exists();
+    if (exists) decryptData();
+    if (storage == PasswordStorage::Sealed && !store.sealed() && store.size() == 0) {
+        // Nothing was loaded to share a key with, so passwords are sealed with a key of their own.
+        store.seal(std::make_unique<PasswordSealer>(CipherEngine::create(CipherParams::generate(), password), 0));
+    }
+    if (!exists) return;
+    if (journal.exists()) {
+        auto records = journal.read(vaultFile.identity());
+        if (!records.empty()) {
+            // Changes left behind by a session that did not exit cleanly.
+            for (const auto& record : records) {
+                applyRecord(record);
+            }
+            compact();
+            return;
         }
+        journal.clear();
     }
+    vaultFile.touch();
 }
 
-auto PasswordList::split(string& str, const string& delimiter) -> vector<string> {
-    vector<string> result;
-    string part;
-    int pos;
-    while((pos = str.find(delimiter)) != string::npos){
-        part = str.substr(0,pos);
-        result.push_back(part);
-        str.erase(0, pos+delimiter.length());
+void PasswordList::parseEntries(std::string_view data, EntryStore &part) {
+    STATS_TIMER(timer, "PasswordList::parseEntries");
+    STATS_BYTES(timer, data.size());
+    std::array<std::string_view, 5> parts;
+    std::size_t count = 0;
+    std::size_t fieldStart = 0;
+    CategoryId categoryId = 0;
+    std::string_view categoryName;
+    bool first = true;
+    for (std::size_t i = 0; i <= data.size(); ++i) {
+        char c = i < data.size() ? data[i] : '\n';
+        if (c != ',' && c != '\n') continue;
+        if (count == parts.size()) throw DecryptionException();
+        parts[count++] = data.substr(fieldStart, i - fieldStart);
+        fieldStart = i + 1;
+        if (c == ',') continue;
+        if (count != parts.size()) throw DecryptionException();
+        // Entries are written grouped by category, so categories are only looked up when they change.
+        if (first || categoryName != parts[0]) {
+            categoryId = part.intern(parts[0]);
+            categoryName = parts[0];
+            first = false;
+        }
+        part.add(categoryId, parts[1], parts[2], parts[3], parts[4]);
+        count = 0;
     }
-    result.push_back(str);
-    return result;
 }
 
 string PasswordList::read() {
-    auto file = std::ifstream(fileName, std::ios::binary);
-    if (file.is_open()) {
-        std::string content((std::istreambuf_iterator<char>(file)),
-                            (std::istreambuf_iterator<char>()));
-        if(!content.empty()) content.erase(content.size() - 12);
-        return content;
-    }
-    return "";
+    STATS_TIMER(timer, "PasswordList::read");
+    auto data = vaultFile.read();
+    STATS_BYTES(timer, data.size());
+    return data;
 }
 
-auto PasswordList::write(std::string data) -> void {
-    std::ofstream os = std::ofstream(fileName, std::ios::binary);
-    data += getTimestamp();
-    os << data;
+auto PasswordList::write(std::string_view data) -> void {
+    STATS_TIMER(timer, "PasswordList::write");
+    STATS_BYTES(timer, data.size());
+    vaultFile.write(data);
 }
 
 void PasswordList::saveData() {
-    write(encryptData());
+    STATS_TIMER(timer, "PasswordList::saveData");
+    finishSave(prepareSave(false));
+}
+
+void PasswordList::compact() {
+    STATS_TIMER(timer, "PasswordList::compact");
+    finishSave(prepareSave(true));
+}
+
+PasswordList::PendingSave PasswordList::prepareSave(bool compact, string taken) {
+    bool rewrite = !vaultFile.exists() || unjournaled || outdated || saveFailed;
+    if (compact) {
+        rewrite = rewrite || journal.exists() || journal.hasPending() || !taken.empty();
+    } else {
+        rewrite = rewrite || journal.size() + taken.size() > Journal::maxSize;
+    }
+    if (!rewrite) return {false, taken + journal.takePending()};
+    STATS_TIMER(timer, "PasswordList::prepareSave");
+    PendingSave save{true, {}, BinaryVault::Layout()};
+    save.data = encryptData(*save.layout);
+    // The new file holds every change, including the ones waiting for the journal.
+    journal.takePending();
+    unjournaled = false;
+    outdated = false;
+    saveFailed = false;
+    return save;
+}
+
+PasswordList::PendingSave PasswordList::takeChanges() {
+    return {false, journal.takePending()};
+}
+
+void PasswordList::finishSave(const PendingSave &save) {
+    try {
+        if (save.rewrite) {
+            write(save.data);
+            journal.removeFile();
+            layout = save.layout;
+        } else {
+            journal.append(vaultFile.identity(), save.data);
+        }
+    } catch (...) {
+        // The changes of the save are no longer waiting in the journal, so only a rewrite can store them now. The
+        // categories it changed are no longer marked either, so that rewrite encodes every category.
+        saveFailed = true;
+        if (save.rewrite) layout.reset();
+        throw;
+    }
+}
+
+void PasswordList::setCompression(Compression codec) {
+    if (codec == compression) return;
+    compression = codec;
+    outdated = true;
+}
+
+void PasswordList::invalidateLayout() {
+    outdated = true;
+}
+
+void PasswordList::applyRecord(const Journal::Record &record) {
+    using Operation = Journal::Operation;
+    const auto& fields = record.fields;
+    switch (record.operation) {
+        case Operation::AddCategory : {
+            if (fields.size() == 1) addCategory(fields[0]);
+            break;
+        }
+        case Operation::RemoveCategory : {
+            if (fields.size() == 1) removeCategory(fields[0]);
+            break;
+        }
+        case Operation::AddEntry : {
+            // Replaying onto a vault that already holds the change leaves it unchanged.
+            if (fields.size() == 5 && !entryExists(fields[1], fields[0])) {
+                addEntry(Entry(fields[0], fields[1], fields[2], fields[3], fields[4]));
+            }
+            break;
+        }
+        case Operation::RemoveEntry : {
+            int index = fields.size() == 2 ? indexInCategory(fields[0], fields[1]) : -1;
+            if (index >= 0) removeEntry(fields[0], index);
+            break;
+        }
+        case Operation::UpdateEntry : {
+            int index = fields.size() == 4 ? indexInCategory(fields[0], fields[1]) : -1;
+            if (index >= 0) editEntry(fields[0], index, static_cast<EntryField>(std::stoi(fields[2])), fields[3]);
+            break;
+        }
+        case Operation::MoveEntry : {
+            auto id = fields.size() == 3 ? findEntryId(fields[0], fields[1]) : std::nullopt;
+            if (id) changeCategory(*id, fields[2]);
+            break;
+        }
+    }
+}
+
+int PasswordList::indexInCategory(std::string_view cat, std::string_view name) const {
+    auto id = findEntryId(cat, name);
+    if (!id) return -1;
+    const auto& ids = entriesMap.find(cat)->second;
+    return static_cast<int>(std::find(ids.begin(), ids.end(), *id) - ids.begin());
+}
+
+std::optional<EntryId> PasswordList::findEntryId(std::string_view cat, std::string_view name) const {
+    ensureIndexed();
+    auto categoryId = store.findCategory(cat);
+    if (!categoryId) return std::nullopt;
+    auto category = nameIndex.find(*categoryId);
+    if (category == nameIndex.end()) return std::nullopt;
+    auto entry = category->second.find(name);
+    if (entry == category->second.end()) return std::nullopt;
+    return entry->second;
+}
+
+EntryId PasswordList::storeEntry(CategoryId categoryId, vector<EntryId> &category, std::string_view name,
+                                 std::string_view password, std::string_view login, std::string_view website) {
+    auto id = store.add(categoryId, name, password, login, website);
+    category.push_back(id);
+    indexEntry(id);
+    if (searchIndexed) searchIndex.add(id, searchableFields(id));
+    for (auto& [fields, index] : sortedIndexes) {
+        index.add(id);
+    }
+    return id;
+}
+
+void PasswordList::releaseEntry(EntryId id) {
+    unindexEntry(id);
+    if (searchIndexed) searchIndex.remove(id, searchableFields(id));
+    for (auto& [fields, index] : sortedIndexes) {
+        index.remove(id);
+    }
+    store.remove(id);
+}
+
+void PasswordList::reclaimSpace() {
+    if (store.wasted() * 2 <= store.memoryUsage()) return;
+    store.repack();
+    nameIndex.clear();
+    loginIndex.clear();
+    websiteIndex.clear();
+    indexed = false;
+}
+
+void PasswordList::ensureIndexed() const {
+    if (indexed) return;
+    indexed = true;
+    loginIndex.reserve(store.size());
+    websiteIndex.reserve(store.size());
+    for (const auto& [category, ids] : entriesMap) {
+        if (ids.empty()) continue;
+        nameIndex[*store.findCategory(category)].reserve(ids.size());
+        for (auto id : ids) {
+            indexEntry(id);
+        }
+    }
+}
+
+void PasswordList::ensureSearchIndexed() const {
+    if (searchIndexed) return;
+    searchIndexed = true;
+    // Going through the storage in id order lets the index append to its lists instead of inserting.
+    for (EntryId id = 0; id < store.idLimit(); ++id) {
+        if (store.contains(id)) searchIndex.add(id, searchableFields(id));
+    }
+}
+
+void PasswordList::indexEntry(EntryId id) const {
+    if (!indexed) return;
+    auto entry = store.get(id);
+    nameIndex[store.category(id)].emplace(entry.getName(), id);
+    if (!entry.getLogin().empty()) loginIndex.emplace(entry.getLogin(), id);
+    if (!entry.getWebsite().empty()) websiteIndex.emplace(entry.getWebsite(), id);
+}
+
+void PasswordList::unindexEntry(EntryId id) const {
+    if (!indexed) return;
+    auto entry = store.get(id);
+    auto erase = [id](EntryIndex& index, std::string_view key) {
+        auto [first, last] = index.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == id) {
+                index.erase(it);
+                return;
+            }
+        }
+    };
+    auto category = nameIndex.find(store.category(id));
+    erase(category->second, entry.getName());
+    if (category->second.empty()) nameIndex.erase(category);
+    erase(loginIndex, entry.getLogin());
+    erase(websiteIndex, entry.getWebsite());
+}
+
+std::array<std::string_view, 4> PasswordList::searchableFields(EntryId id) const {
+    auto entry = store.get(id);
+    return {entry.getName(), entry.getLogin(), entry.getWebsite(), entry.getCategory()};
+}
+
+void PasswordList::reindexSearch(EntryId id, const std::array<std::string_view, 4> &previous) const {
+    if (searchIndexed) searchIndex.update(id, previous, searchableFields(id));
 }
 
 auto PasswordList::getCategories() -> vector<string> {
@@ -63,10 +292,11 @@ auto PasswordList::getCategories() -> vector<string> {
 
 auto PasswordList::addEntry(const Entry& entry) -> void {
     auto cat = entry.getCategory();
-    if(!entriesMap.contains(cat)){
-        addCategory(cat);
-    }
-    entriesMap[cat].push_back(entry);
+    journal.record(Journal::Operation::AddEntry,
+                   {cat, entry.getName(), entry.getPassword(), entry.getLogin(), entry.getWebsite()});
+    storeEntry(store.intern(cat), entriesMap[cat], entry.getName(), entry.getPassword(), entry.getLogin(),
+               entry.getWebsite());
+    dirtyCategories.insert(cat);
 }
 
 auto PasswordList::categoryExists(const string &cat) -> bool {
@@ -74,7 +304,10 @@ auto PasswordList::categoryExists(const string &cat) -> bool {
 }
 
 auto PasswordList::addCategory(const string &cat) -> void {
-    entriesMap.insert(std::pair<string, vector<Entry>>(cat,vector<Entry>()));
+    if (entriesMap.insert(std::pair<string, vector<EntryId>>(cat,vector<EntryId>())).second) {
+        store.intern(cat);
+        journal.record(Journal::Operation::AddCategory, {cat});
+    }
 }
 
 auto PasswordList::empty() -> bool {
@@ -87,89 +320,437 @@ auto PasswordList::empty() -> bool {
 }
 
 auto PasswordList::removeEntry(const string& category, int index) -> void {
-    entriesMap[category].erase(entriesMap[category].begin() + index);
+    auto& ids = entriesMap[category];
+    auto id = ids[index];
+    journal.record(Journal::Operation::RemoveEntry, {category, store.field(id, EntryField::Name)});
+    releaseEntry(id);
+    ids.erase(ids.begin() + index);
+    dirtyCategories.insert(category);
+    reclaimSpace();
 }
 
-auto PasswordList::removeEntry(const string &category, const std::vector<Entry>::iterator &iterator) -> void {
-    entriesMap[category].erase(iterator);
+void PasswordList::removeCategory(const string& category) {
+    auto iterator = entriesMap.find(category);
+    if (iterator == entriesMap.end()) return;
+    journal.record(Journal::Operation::RemoveCategory, {category});
+    for (auto id : iterator->second) {
+        releaseEntry(id);
+    }
+    entriesMap.erase(iterator);
+    dirtyCategories.insert(category);
+    reclaimSpace();
 }
 
-void PasswordList::removeCategory(const string& category) {
-    entriesMap.erase(category);
+void PasswordList::moveEntry(const string &newCat, const Entry &entry) {
+    if (auto id = findEntryId(entry.getCategory(), entry.getName())) changeCategory(*id, newCat);
+}
+
+void PasswordList::changeCategory(EntryId id, const string &newCat) {
+    auto cat = store.get(id).getCategory();
+    journal.record(Journal::Operation::MoveEntry, {cat, store.field(id, EntryField::Name), newCat});
+    dirtyCategories.emplace(cat);
+    auto& ids = entriesMap.find(cat)->second;
+    ids.erase(std::find(ids.begin(), ids.end(), id));
+    auto previous = searchableFields(id);
+    unindexEntry(id);
+    unsortEntry(id, EntryField::Category);
+    store.setField(id, EntryField::Category, newCat);
+    entriesMap[newCat].push_back(id);
+    dirtyCategories.insert(newCat);
+    indexEntry(id);
+    sortEntry(id, EntryField::Category);
+    reindexSearch(id, previous);
 }
 
-void PasswordList::moveEntry(string &newCat, Entry &entry) {
-    auto& vectorCopy = entriesMap[entry.getCategory()];
-    removeEntry(entry.getCategory(),std::find(vectorCopy.begin(),vectorCopy.end(), entry));
-    entry.setCategory(newCat);
-    addEntry(entry);
+void PasswordList::editEntry(const string &category, int index, EntryField field, const string &value) {
+    auto id = entriesMap[category][index];
+    if (field == EntryField::Category) {
+        changeCategory(id, value);
+        return;
+    }
+    journal.record(Journal::Operation::UpdateEntry,
+                   {category, store.field(id, EntryField::Name), std::to_string(static_cast<int>(field)), value});
+    // The previous fields stay readable until the store is repacked, which only happens afterwards.
+    auto previous = searchableFields(id);
+    unindexEntry(id);
+    unsortEntry(id, field);
+    store.setField(id, field, value);
+    dirtyCategories.insert(category);
+    indexEntry(id);
+    sortEntry(id, field);
+    reindexSearch(id, previous);
+    reclaimSpace();
+}
+
+vector<Entry> PasswordList::getEntriesInCategory(const string& cat) {
+    vector<Entry> result;
+    auto iterator = entriesMap.find(cat);
+    if (iterator == entriesMap.end()) return result;
+    result.reserve(iterator->second.size());
+    for (auto id : iterator->second) {
+        result.push_back(store.get(id).toEntry());
+    }
+    return result;
+}
+
+std::optional<EntryRef> PasswordList::findEntry(std::string_view cat, std::string_view name) const {
+    auto id = findEntryId(cat, name);
+    if (!id) return std::nullopt;
+    return store.get(*id);
+}
+
+vector<EntryRef> PasswordList::findEntries(EntryField field, std::string_view value) const {
+    ensureIndexed();
+    vector<EntryRef> result;
+    auto collect = [&](auto first, auto last) {
+        for (auto it = first; it != last; ++it) {
+            result.push_back(store.get(it->second));
+        }
+    };
+    switch (field) {
+        case EntryField::Name : {
+            for (const auto& [category, names] : nameIndex) {
+                auto [first, last] = names.equal_range(value);
+                collect(first, last);
+            }
+            break;
+        }
+        case EntryField::Login : {
+            auto [first, last] = loginIndex.equal_range(value);
+            collect(first, last);
+            break;
+        }
+        case EntryField::Website : {
+            auto [first, last] = websiteIndex.equal_range(value);
+            collect(first, last);
+            break;
+        }
+        default : break;
+    }
+    return result;
+}
+
+vector<SearchMatch> PasswordList::search(std::string_view query, SearchMode mode) const {
+    vector<SearchMatch> result;
+    if (query.empty()) return result;
+    string lowered(query);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), SearchIndex::toLower);
+    auto check = [&](EntryId id) {
+        auto entry = store.get(id);
+        const std::pair<EntryField, std::string_view> fields[] = {
+                {EntryField::Name, entry.getName()}, {EntryField::Website, entry.getWebsite()},
+                {EntryField::Login, entry.getLogin()}, {EntryField::Category, entry.getCategory()}};
+        std::optional<SearchMatch> best;
+        for (auto [field, value] : fields) {
+            auto kind = SearchIndex::match(value, lowered, mode);
+            if (kind && (!best || *kind < best->kind)) best = SearchMatch{entry, field, *kind};
+        }
+        if (best) result.push_back(*best);
+    };
+    if (lowered.size() < SearchIndex::minQueryLength) {
+        // Too short to have a trigram, so every entry is a candidate.
+        for (EntryId id = 0; id < store.idLimit(); ++id) {
+            if (store.contains(id)) check(id);
+        }
+    } else {
+        ensureSearchIndexed();
+        for (auto id : searchIndex.candidates(lowered)) {
+            check(id);
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const SearchMatch& a, const SearchMatch& b) {
+        return a.rank() < b.rank();
+    });
+    return result;
+}
+
+void PasswordList::sortEntry(EntryId id, EntryField field) const {
+    for (auto& [fields, index] : sortedIndexes) {
+        if (index.covers(field)) index.add(id);
+    }
+}
+
+void PasswordList::unsortEntry(EntryId id, EntryField field) const {
+    for (auto& [fields, index] : sortedIndexes) {
+        if (index.covers(field)) index.remove(id);
+    }
 }
 
-vector<Entry> &PasswordList::getEntriesInCategory(string cat) {
-    return entriesMap[cat];
+void PasswordList::forEachSorted(EntryField first, EntryField second,
+                                 const std::function<void(const EntryRef &)> &visit) const {
+    auto iterator = sortedIndexes.find({first, second});
+    if (iterator == sortedIndexes.end()) {
+        iterator = sortedIndexes.try_emplace({first, second}, store, first, second).first;
+        vector<EntryId> ids;
+        ids.reserve(store.size());
+        for (EntryId id = 0; id < store.idLimit(); ++id) {
+            if (store.contains(id)) ids.push_back(id);
+        }
+        iterator->second.add(std::move(ids));
+    }
+    for (auto id : iterator->second) {
+        visit(store.get(id));
+    }
 }
 
 vector<Entry> PasswordList::getAllEntries() {
-    vector<Entry> entries;
+    vector<Entry> result;
+    result.reserve(store.size());
     for (const auto& pair : entriesMap) {
-        for (auto entry : pair.second) {
-            entries.push_back(entry);
+        for (auto id : pair.second) {
+            result.push_back(store.get(id).toEntry());
         }
     }
-    return entries;
+    return result;
 }
 
-string PasswordList::encryptData() {
-    auto fe = FileEncryptor();
+std::size_t PasswordList::pieceCount(std::size_t size) const {
+    // Small files are not worth handing to other threads.
+    constexpr std::size_t minPieceSize = 1 << 18;
+    return std::clamp<std::size_t>(size / minPieceSize, 1, pool.size() + 1);
+}
+
+void PasswordList::applyCipher(std::span<const std::byte> source, std::span<std::byte> destination,
+                               const CipherEngine &engine, std::uint64_t stream) const {
+    auto pieces = pieceCount(source.size());
+    pool.run(pieces, [&](std::size_t piece) {
+        auto start = source.size() * piece / pieces;
+        auto size = source.size() * (piece + 1) / pieces - start;
+        STATS_TIMER(pieceTimer, "FileEncryptor::apply");
+        STATS_BYTES(pieceTimer, size);
+        FileEncryptor().decrypt(source.subspan(start, size), destination.subspan(start, size), engine,
+                                stream + start);
+    });
+}
+
+string PasswordList::encryptData(BinaryVault::Layout &written) {
+    STATS_TIMER(timer, "PasswordList::encryptData");
+    // Segments are only copied from a file in the current layout, while its keystream lasts. Otherwise every save
+    // draws a new salt and nonce, so no two versions of the file share a keystream.
+    bool partial = layout && !outdated && layout->streamEnd < BinaryVault::streamLimit / 2;
+    auto header = partial ? layout->header : VaultHeader::generate(password);
+    header.compression = compression;
+    VaultFile::Mapping mapping;
+    string fallback;
+    std::span<const std::byte> previous;
+    if (partial) {
+        mapping = vaultFile.map();
+        if (mapping.valid()) {
+            previous = mapping.data();
+        } else {
+            fallback = read();
+            previous = std::as_bytes(std::span(fallback));
+        }
+        previous = previous.subspan(std::min(previous.size(), header.storedSize()));
+    }
+    // A segment is copied only if the file still holds it as it was written, which its checksum tells.
+    auto copyable = [&](const string& category) -> const BinaryVault::Segment* {
+        if (!partial || dirtyCategories.contains(category)) return nullptr;
+        auto segment = std::ranges::lower_bound(layout->segments, category, {}, &BinaryVault::Segment::category);
+        if (segment == layout->segments.end() || segment->category != category ||
+            segment->offset > previous.size() || segment->size > previous.size() - segment->offset ||
+            BinaryVault::checksum(previous.subspan(segment->offset, segment->size)) != segment->checksum) {
+            return nullptr;
+        }
+        return &*segment;
+    };
     string content;
+    header.appendTo(content);
+    BinaryVault::Writer writer(content, compression, partial ? layout->streamEnd : 0);
     for (const auto &pair: entriesMap) {
-        for (int i = 0; i < pair.second.size(); ++i) {
-            content += pair.second.at(i).getFileString() + "\n";
+        if (auto segment = copyable(pair.first)) {
+            writer.copyCategory(*segment, std::span(layout->blocks).subspan(segment->firstBlock, segment->blockCount),
+                                previous.subspan(segment->offset, segment->size));
+            continue;
+        }
+        writer.beginCategory(pair.first);
+        for (auto id : pair.second) {
+            writer.add(store.get(id));
         }
     }
-    if (!content.empty()) {
-        content.pop_back();
+    auto engine = CipherEngine::create(header.cipher, password);
+    written = writer.finish([&](std::span<std::byte> data, std::uint64_t stream) {
+        applyCipher(data, data, *engine, stream);
+    });
+    written.header = header;
+    dirtyCategories.clear();
+    if (written.streamEnd > BinaryVault::streamLimit) {
+        layout.reset();
+        return encryptData(written);
     }
-    content = fe.encrypt(content, password);
+    STATS_BYTES(timer, content.size());
     return content;
 }
 
-void PasswordList::decryptData(std::string data) {
-    auto fe = FileEncryptor();
-    if(!data.empty()) {
-        data = fe.decrypt(data, password);
-        auto entries = split(data, "\n");
-        for (auto entry: entries) {
-            auto parts = split(entry, ",");
-            if(parts.size() != 5) throw DecryptionException();
-            auto newEntry = Entry(parts.at(0), parts.at(1), parts.at(2),
-                                  parts.at(3), parts.at(4));
-            addEntry(newEntry);
+void PasswordList::decryptData() {
+    STATS_TIMER(timer, "PasswordList::decryptData");
+    string fallback;
+    std::span<const std::byte> source;
+    auto mapping = vaultFile.map();
+    if (mapping.valid()) {
+        source = mapping.data();
+    } else {
+        fallback = read();
+        source = std::as_bytes(std::span(fallback));
+    }
+    if (source.empty()) return;
+    STATS_BYTES(timer, source.size());
+    // Files without a header were written before the cipher engines existed and are XORed with the password.
+    auto header = VaultHeader::read(source);
+    if (header && !header->accepts(password)) throw DecryptionException("Wrong password.\n");
+    outdated = !header || header->version != VaultHeader::currentVersion;
+    auto engine = CipherEngine::create(header ? header->cipher : CipherParams{Cipher::Xor}, password);
+    auto headerSize = header ? header->storedSize() : 0;
+    source = source.subspan(headerSize);
+    if (header && header->version >= VaultHeader::binaryVersion) {
+        loadBinary(source, *header);
+        return;
+    }
+    if (source.empty()) return;
+    // The mapping is decrypted into a buffer that is never initialized; the fallback is decrypted in place.
+    std::unique_ptr<char[]> buffer;
+    char* data = fallback.data() + headerSize;
+    if (mapping.valid()) {
+        buffer = std::make_unique_for_overwrite<char[]>(source.size());
+        data = buffer.get();
+    }
+    applyCipher(source, std::as_writable_bytes(std::span(data, source.size())), *engine);
+    loadText(std::string_view(data, source.size()));
+}
+
+void PasswordList::loadText(std::string_view text) {
+    auto pieces = pieceCount(text.size());
+    auto pieceStart = [&](std::size_t piece) { return text.size() * piece / pieces; };
+    // Every piece owns the lines starting inside it, so a line crossing a boundary belongs to the earlier piece.
+    auto lineStart = [&](std::size_t piece) {
+        if (piece == 0) return std::size_t(0);
+        if (piece == pieces) return text.size();
+        auto newline = text.find('\n', pieceStart(piece) - 1);
+        return newline == std::string_view::npos ? text.size() : newline + 1;
+    };
+    vector<EntryStore> parts(pieces);
+    pool.run(pieces, [&](std::size_t piece) {
+        auto start = lineStart(piece);
+        auto end = lineStart(piece + 1);
+        if (start >= end) return;
+        auto lines = text.substr(start, end - start);
+        if (lines.back() == '\n') lines.remove_suffix(1);
+        parseEntries(lines, parts[piece]);
+    });
+    mergeParts(parts);
+}
+
+void PasswordList::loadBinary(std::span<const std::byte> source, const VaultHeader &header) {
+    auto engine = CipherEngine::create(header.cipher, password);
+    BinaryVault::Reader reader(source, *engine, header);
+    if (header.version >= 5) compression = header.compression;
+    bool segmented = header.version >= VaultHeader::segmentedVersion;
+    if (segmented) {
+        const auto& segments = reader.layout().segments;
+        pool.run(segments.size(), [&](std::size_t segment) { reader.verify(segment); });
+    }
+    bool seal = storage == PasswordStorage::Sealed && reader.canSeal();
+    if (seal) {
+        // The sealed passwords are the encrypted passwords of the file, so the sealer uses the key of the file and
+        // seals new passwords past any position the file may use.
+        auto firstOffset = segmented ? BinaryVault::streamLimit : source.size();
+        store.seal(std::make_unique<PasswordSealer>(CipherEngine::create(header.cipher, password), firstOffset));
+    }
+    const auto& blocks = reader.blocks();
+    auto recordsSize = blocks.empty() ? 0 : blocks.back().offset + blocks.back().size - blocks.front().offset;
+    auto pieces = pieceCount(recordsSize);
+    // Every piece reads the blocks starting in its share of the records.
+    auto blockStart = [&](std::size_t piece) {
+        if (piece == pieces) return blocks.size();
+        auto offset = blocks.front().offset + recordsSize * piece / pieces;
+        return static_cast<std::size_t>(std::ranges::lower_bound(blocks, offset, {}, &BinaryVault::Block::offset) -
+                                        blocks.begin());
+    };
+    vector<EntryStore> parts(pieces);
+    pool.run(pieces, [&](std::size_t piece) {
+        reader.read(blockStart(piece), blockStart(piece + 1), parts[piece], seal);
+    });
+    mergeParts(parts);
+    // Categories without entries are only listed in the directory.
+    for (const auto& name : reader.categories()) {
+        entriesMap.try_emplace(name);
+    }
+    if (segmented) layout = reader.layout();
+}
+
+void PasswordList::mergeParts(vector<EntryStore> &parts) {
+    // Nothing is indexed while the file is loaded, so the entries only have to be added to their categories.
+    vector<vector<EntryId>*> categories;
+    for (auto& part : parts) {
+        for (auto id = store.append(std::move(part)); id < store.idLimit(); ++id) {
+            auto category = store.category(id);
+            if (category >= categories.size()) categories.resize(category + 1, nullptr);
+            if (categories[category] == nullptr) {
+                categories[category] = &entriesMap[string(store.categoryName(category))];
+            }
+            categories[category]->push_back(id);
         }
     }
 }
 
-string PasswordList::getTimestamp() {
-    std::time_t currentTime = std::time(nullptr);
-    std::tm* timeInfo = std::localtime(&currentTime);
-    std::string timestamp = std::to_string(timeInfo->tm_year - 100) +
-                            (timeInfo->tm_hour < 10 ? "0" : "") + std::to_string(timeInfo->tm_hour) +
-                            (timeInfo->tm_mon + 1 < 10 ? "0" : "") + std::to_string(timeInfo->tm_mon + 1) +
-                            (timeInfo->tm_min < 10 ? "0" : "") + std::to_string(timeInfo->tm_min) +
-                            (timeInfo->tm_mday < 10 ? "0" : "") + std::to_string(timeInfo->tm_mday) +
-                            (timeInfo->tm_sec < 10 ? "0" : "") + std::to_string(timeInfo->tm_sec);
-    return timestamp;
+std::size_t PasswordList::exportEntries(std::ostream &output, ExchangeFormat format) const {
+    STATS_TIMER(timer, "PasswordList::exportEntries");
+    EntryWriter writer(output, format);
+    std::size_t count = 0;
+    for (const auto& [category, ids] : entriesMap) {
+        for (auto id : ids) {
+            writer.write(store.get(id));
+        }
+        count += ids.size();
+    }
+    return count;
 }
 
-bool PasswordList::entryExists(const string& name, const string& cat) {
-    auto entry = Entry(cat, name, "", "", "");
-    for(auto e : getAllEntries()){
-        if(e == entry) return true;
+ImportResult PasswordList::importEntries(std::istream &input, ExchangeFormat format) {
+    STATS_TIMER(timer, "PasswordList::importEntries");
+    EntryReader reader(input, format);
+    searchIndex.clear();
+    searchIndexed = false;
+    sortedIndexes.clear();
+    // The hash indexes are kept: they find duplicates, and adding to them costs little.
+    ensureIndexed();
+    ImportResult result;
+    unjournaled = true;
+    while (auto entry = reader.next()) {
+        const auto& cat = entry->getCategory();
+        const auto& name = entry->getName();
+        if (cat.empty() || name.empty() || !isStorable(cat) || !isStorable(name) ||
+            !isStorable(entry->getPassword()) || !isStorable(entry->getLogin()) || !isStorable(entry->getWebsite())) {
+            ++result.rejected;
+            continue;
+        }
+        if (findEntryId(cat, name)) {
+            ++result.duplicates;
+            continue;
+        }
+        auto& ids = entriesMap[cat];
+        storeEntry(store.intern(cat), ids, name, entry->getPassword(), entry->getLogin(), entry->getWebsite());
+        dirtyCategories.insert(cat);
+        ++result.added;
     }
-    return false;
+    return result;
+}
+
+bool PasswordList::isStorable(std::string_view value) {
+    return value.size() <= EntryStore::maxFieldSize;
+}
+
+bool PasswordList::entryExists(const string& name, const string& cat) const {
+    return findEntryId(cat, name).has_value();
 }
 
 bool PasswordList::categoryIsEmpty(const string &cat) {
-    return getEntriesInCategory(cat).empty();
+    auto iterator = entriesMap.find(cat);
+    return iterator == entriesMap.end() || iterator->second.empty();
+}
+
+std::size_t PasswordList::getEntryCount(const string &cat) const {
+    auto iterator = entriesMap.find(cat);
+    return iterator == entriesMap.end() ? 0 : iterator->second.size();
 }
 
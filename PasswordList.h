@@ -2,13 +2,51 @@
 #define PASSWORDMANAGER_PASSWORDLIST_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include "Entry.h"
+#include "EntryStore.h"
+#include "EntryExchange.h"
+#include "BinaryVault.h"
+#include "CipherEngine.h"
+#include "VaultFile.h"
+#include "VaultHeader.h"
+#include "Journal.h"
+#include "SearchIndex.h"
+#include "SortedIndex.h"
+#include "ThreadPool.h"
+#include <array>
+#include <functional>
 #include <map>
+#include <optional>
+#include <set>
+#include <span>
+#include <unordered_map>
 
 using std::string, std::vector;
 
+/**
+* @brief Hash index from field values to the ids of the entries holding them. The keys are views of the fields
+* in the entry store, so building the index does not copy any field.
+*/
+using EntryIndex = std::unordered_multimap<std::string_view, EntryId>;
+
+/**
+* @brief How a password list keeps passwords in memory.
+*/
+enum class PasswordStorage {
+    /**
+     * Passwords are decrypted when the file is loaded and kept in plain text.
+     */
+    Plain,
+    /**
+     * Passwords stay encrypted in memory and are only decrypted when read, see PasswordSealer. Vaults written
+     * before version 4 of the vault header are loaded in plain text until they are saved again.
+     */
+    Sealed
+};
+
 /**
 * @class PasswordList
 * @brief Class representing a list of password entries.
@@ -21,51 +59,257 @@ class PasswordList {
     /** The file name associated with the password list.
     **/
     string fileName;
+    /**
+     * The file the password list is read from and saved to.
+     */
+    VaultFile vaultFile;
+    /**
+     * The journal recording changes made since the vault file was last written.
+     */
+    Journal journal;
     /**
      *The password used to decrypt the password list file.
      */
     string password;
     /**
-     * Map of category names to lists of Entry objects.
+     * The threads used to load the password list file.
+     */
+    ThreadPool& pool;
+    /**
+     * How passwords are kept in memory.
+     */
+    PasswordStorage storage;
+    /**
+     * The codec the records of the file are compressed with when it is written.
+     */
+    Compression compression = Compression::Lz4;
+    /**
+     * Storage of all entries, indexed by their id.
+     */
+    EntryStore store;
+    /**
+     * Map of category names to the ids of their entries, in insertion order.
+     */
+    std::map<string, vector<EntryId>, std::less<>> entriesMap;
+    /**
+     * Index of entry ids by category and then by name.
+     */
+    mutable std::unordered_map<CategoryId, EntryIndex> nameIndex;
+    /**
+     * Index of entry ids by login. Entries without a login are not indexed.
+     */
+    mutable EntryIndex loginIndex;
+    /**
+     * Index of entry ids by website. Entries without a website are not indexed.
+     */
+    mutable EntryIndex websiteIndex;
+    /**
+     * Whether the indexes have been built. They are built on the first lookup rather than on unlock,
+     * so opening a vault does not pay for them, and kept up to date from then on.
      */
-    std::map<string, vector<Entry>> entriesMap;
+    mutable bool indexed = false;
+    /**
+     * Trigram index over the name, login, website and category of every entry, used for full-text search.
+     */
+    mutable SearchIndex searchIndex;
+    /**
+     * Whether the search index has been built. Like the other indexes it is built on the first search.
+     */
+    mutable bool searchIndexed = false;
+    /**
+     * Indexes of the entries ordered by pairs of fields. An index is built the first time entries are listed
+     * in its order and kept up to date from then on.
+     */
+    mutable std::map<std::pair<EntryField, EntryField>, SortedIndex> sortedIndexes;
+    /**
+     * Whether the password list holds changes that were not recorded in the journal, so the next save has to
+     * rewrite the file.
+     */
+    bool unjournaled = false;
+    /**
+     * Whether the file was stored in an older format, so the next save has to rewrite it in the current one.
+     */
+    bool outdated = false;
+    /**
+     * Whether a save failed after taking its changes from the journal, so the next save has to rewrite the file.
+     * Like the journal file, it is only touched by the functions of saving.
+     */
+    bool saveFailed = false;
+    /**
+     * Where the categories are stored in the file as last loaded or saved, or an empty optional if the file is not
+     * in the segmented layout, so the next rewrite has to encode every category. Like the journal file, it is only
+     * touched by the functions of saving.
+     */
+    std::optional<BinaryVault::Layout> layout;
+    /**
+     * The categories changed since the file was last rewritten, which the next rewrite encodes again rather than
+     * copying their segments.
+     */
+    std::set<string, std::less<>> dirtyCategories;
     /**
     @brief Reads the password list from the associated file.
     */
     string read();
     /**
-    @brief Writes the data to the associated file.
+    @brief Atomically replaces the associated file with the data.
     */
-    auto write(std::string data) -> void;
+    auto write(std::string_view data) -> void;
     /**
-    @brief Splits a string into multiple substrings using the specified delimiter.
-    @param str The string to be split.
-    @param delimiter The delimiter used to split the string.
-    @return A vector of substrings.
+    @brief Parses decrypted data in a single pass and packs the entries it describes into a store.
+    Every line holds one entry with 5 comma separated fields. Fields are read as views into the data.
+    Parsing does not touch the password list, so separate pieces of a file can be parsed in parallel.
+    @param data Decrypted data to parse, made of whole lines.
+    @param part The store receiving the entries.
+    @throws DecryptionException If a line does not consist of exactly 5 fields.
     */
-    static vector<string> split(string& str, const string& delimiter);
+    static void parseEntries(std::string_view data, EntryStore& part);
     /**
-    @brief Encrypts data stored in password list.
+    @brief Chooses how many pieces data is split into to be processed in parallel.
+    @param size The size of the data.
+    @return The number of pieces, at most one per thread.
+    */
+    std::size_t pieceCount(std::size_t size) const;
+    /**
+    @brief Encrypts or decrypts data with a cipher engine, in parallel pieces on the thread pool.
+    @param source The data to process.
+    @param destination The buffer receiving the result. Either the source itself or not overlapping it.
+    @param engine The engine holding the key.
+    @param stream Position of the keystream the source starts at.
+    */
+    void applyCipher(std::span<const std::byte> source, std::span<std::byte> destination,
+                     const CipherEngine& engine, std::uint64_t stream = 0) const;
+    /**
+    @brief Encodes the data stored in password list in the segmented binary layout and encrypts it with ChaCha20.
+     If the file is already in that layout, only the changed categories are encoded; the segments of the others are
+     copied from the file, and the header and its key are kept. Otherwise, or once the keystream of the file runs
+     out, every category is encoded behind a vault header holding a new salt and nonce.
+    Marks every category clean.
+    @param written Receives the layout of the data.
     @return A string representation of encrypted data.
     */
-    string encryptData();
+    string encryptData(BinaryVault::Layout& written);
+    /**
+    @brief Decrypts the data stored in the associated file and saves it in password list.
+    The file is memory mapped, falling back to reading it into memory if it cannot be mapped. The cipher and the
+    layout of the data are taken from the vault header; files without one are XORed with the password and hold
+    text. A wrong password is rejected by the key check of the header before any data is decrypted.
+    @throws DecryptionException If the password is wrong or the file is damaged.
+    */
+    void decryptData();
+    /**
+    @brief Loads decrypted data in the text layout of older versions. The data is split into one piece per thread;
+     every thread parses the lines starting in its piece into a store of its own.
+    @param text The decrypted data.
+    @throws DecryptionException If a line does not consist of exactly 5 fields.
+    */
+    void loadText(std::string_view text);
+    /**
+    @brief Loads encrypted data in the binary layout. The records are split at block boundaries into one piece per
+     thread; every thread decrypts and parses the blocks of its piece into a store of its own. When passwords are
+     sealed and the layout allows it, the passwords are copied without being decrypted, and stay encrypted with
+     the key of the file.
+    @param source The encrypted data following the vault header.
+    @param header The header of the file.
+    @throws DecryptionException If the data is damaged.
+    */
+    void loadBinary(std::span<const std::byte> source, const VaultHeader& header);
+    /**
+    @brief Moves the entries of stores loaded in parallel into the password list, in the order of the stores.
+    @param parts The stores. They are left empty.
+    */
+    void mergeParts(vector<EntryStore>& parts);
+    /**
+    @brief Applies a change read back from the journal.
+    @param record The change to apply.
+    */
+    void applyRecord(const Journal::Record& record);
+    /**
+    @brief Finds an entry by its name within a category.
+    @param cat The category of the entry.
+    @param name The name of the entry.
+    @return The id of the entry, or an empty optional if there is no such entry.
+    */
+    std::optional<EntryId> findEntryId(std::string_view cat, std::string_view name) const;
+    /**
+    @brief Stores an entry and adds it to the indexes, without recording it in the journal.
+    @param categoryId The interned category of the entry.
+    @param category The ids of the entries in the entry's category, which the new id is appended to.
+    @param name The name of the entry.
+    @param password The password of the entry.
+    @param login The login associated with the entry.
+    @param website The website associated with the entry.
+    @return The id of the stored entry.
+    */
+    EntryId storeEntry(CategoryId categoryId, vector<EntryId>& category, std::string_view name,
+                       std::string_view password, std::string_view login, std::string_view website);
+    /**
+    @brief Removes an entry from the storage and the indexes. The id is not removed from its category.
+    @param id The id of the entry.
+    */
+    void releaseEntry(EntryId id);
+    /**
+    @brief Moves an entry to a new category and records the change in the journal.
+    @param id The id of the entry.
+    @param newCat The new category for the entry.
+    */
+    void changeCategory(EntryId id, const string& newCat);
+    /**
+    @brief Repacks the entry store once most of its memory is held by changed or removed entries.
+     The indexes keyed by views of the fields are dropped and rebuilt on the next lookup.
+    */
+    void reclaimSpace();
+    /**
+    @brief Builds the indexes if they have not been built yet.
+    */
+    void ensureIndexed() const;
+    /**
+    @brief Builds the search index if it has not been built yet.
+    */
+    void ensureSearchIndexed() const;
+    /**
+    @brief Adds an entry to the indexes.
+    @param id The id of the entry.
+    */
+    void indexEntry(EntryId id) const;
     /**
-    @brief Decrypts the passed data and saves it in password list.
-    @param data Data to decrypt
+    @brief Removes an entry from the indexes.
+    @param id The id of the entry.
     */
-    void decryptData(std::string data);
+    void unindexEntry(EntryId id) const;
     /**
-    @brief Gets current date and time, converts it to a string and ciphers it.
-    @return A string representation of a timestamp.
+    @brief Adds an entry back to the sorted indexes that depend on a field, after the field has changed.
+    @param id The id of the entry.
+    @param field The changed field.
     */
-    string getTimestamp();
+    void sortEntry(EntryId id, EntryField field) const;
+    /**
+    @brief Removes an entry from the sorted indexes that depend on a field, before the field changes.
+    @param id The id of the entry.
+    @param field The field about to change.
+    */
+    void unsortEntry(EntryId id, EntryField field) const;
+    /**
+    @brief Retrieves the fields of an entry covered by the search index.
+    @param id The id of the entry.
+    @return The name, login, website and category of the entry.
+    */
+    std::array<std::string_view, 4> searchableFields(EntryId id) const;
+    /**
+    @brief Updates the search index after an entry was changed in place.
+    @param id The id of the entry.
+    @param previous The searchable fields of the entry from before the change.
+    */
+    void reindexSearch(EntryId id, const std::array<std::string_view, 4>& previous) const;
 public:
     /**
      * @brief Constructs a PasswordList object with the specified file name and password.
      * @param fileName The file name associated with the password list.
      * @param password The password used to decrypt the password list file.
+     * @param pool The threads used to load the password list file.
+     * @param storage How passwords are kept in memory.
      */
-    explicit PasswordList(const string &fileName, const string& password);
+    explicit PasswordList(const string &fileName, const string& password, ThreadPool& pool = ThreadPool::shared(),
+                          PasswordStorage storage = PasswordStorage::Sealed);
     /**
     @brief Retrieves the categories in the password list.
     @return A vector of category names.
@@ -83,12 +327,6 @@ public:
     */
     auto removeEntry(const string& category, int index) -> void;
     /**
-    @brief Removes an entry from the password list based on its category and iterator.
-    @param category The category of the entry.
-    @param iterator The iterator pointing to the entry in its category.
-    */
-    auto removeEntry(const string& category, const std::vector<Entry>::iterator& iterator) -> void;
-    /**
     @brief Checks if a category exists in the password list.
     @param cat The category name to check.
     @return True if the category exists, false otherwise.
@@ -119,29 +357,165 @@ public:
     @param newCat The new category for the entry.
     @param entry The entry to be moved.
     */
-    void moveEntry(string& newCat, Entry& entry);
+    void moveEntry(const string& newCat, const Entry& entry);
+    /**
+    @brief Changes a field of an entry. Changing the category moves the entry to that category.
+    @param category The category of the entry.
+    @param index The index of the entry within its category.
+    @param field The field to change.
+    @param value The new value of the field.
+    */
+    void editEntry(const string& category, int index, EntryField field, const string& value);
     /**
     @brief Retrieves the entries in a specific category.
     @param cat The category name.
-    @return A reference to the vector of entries in the category.
+    @return A vector of copies of the entries in the category.
+    */
+    vector<Entry> getEntriesInCategory(const string& cat);
+    /**
+    @brief Finds an entry by its name within a category using the index.
+    @param cat The category of the entry.
+    @param name The name of the entry.
+    @return A view of the entry, or an empty optional if there is no such entry.
+     The view is valid until the password list is modified.
     */
-    vector<Entry>& getEntriesInCategory(string cat);
+    std::optional<EntryRef> findEntry(std::string_view cat, std::string_view name) const;
     /**
-    @brief Saves data from password list to a file.
+    @brief Finds all entries whose name, login or website is equal to the given value using the indexes.
+    @param field The field to compare. Must be EntryField::Name, EntryField::Login or EntryField::Website.
+    @param value The value to look for.
+    @return Views of the matching entries, valid until the password list is modified.
+    */
+    vector<EntryRef> findEntries(EntryField field, std::string_view value) const;
+    /**
+    @brief Searches the name, login, website and category of every entry for the query, ignoring case.
+    Results are ranked by how closely the query matches (exact, then prefix, then substring)
+    and then by the field that matched (name, then website, then login, then category).
+    @param query The text to look for.
+    @param mode Whether the query may appear anywhere in a field or only at its beginning.
+    @return The matching entries, best matches first. The views are valid until the password list is modified.
+    */
+    vector<SearchMatch> search(std::string_view query, SearchMode mode = SearchMode::Substring) const;
+    /**
+    @brief Visits all entries ordered by two fields, in the order of Entry::compareEntries.
+    The order is kept in an index that is built on the first call for a pair of fields and then updated
+    on every change, so listing the entries does not copy or sort them.
+    @param first The field to sort by. Must not be EntryField::Password.
+    @param second The field to sort entries with an equal first field by. Must not be EntryField::Password.
+    @param visit The function called with every entry.
+    */
+    void forEachSorted(EntryField first, EntryField second, const std::function<void(const EntryRef&)>& visit) const;
+    /**
+    @brief Saves the changes made to the password list. The changes are appended to the journal, so the cost
+     depends on the size of the changes rather than the size of the password list. The journal is compacted
+     into the file once it grows too large.
     */
     void saveData();
     /**
+    @brief Writes all entries to a stream, one at a time, in the order they are saved in.
+    @param output The stream to write to.
+    @param format The format to write.
+    @return The number of entries written.
+    */
+    std::size_t exportEntries(std::ostream& output, ExchangeFormat format) const;
+    /**
+    @brief Adds the entries read from a stream, one at a time. Entries are not recorded in the journal one by one:
+     the next save rewrites the file instead. The search and sorted indexes are dropped rather than updated for
+     every entry and are rebuilt when next used.
+    Entries already in the password list and entries that cannot be stored are skipped and counted.
+    @param input The stream to read from.
+    @param format The format of the stream.
+    @return The counts of added and skipped entries.
+    @throws std::runtime_error If the stream is malformed. The entries read before the error are kept.
+    */
+    ImportResult importEntries(std::istream& input, ExchangeFormat format);
+    /**
+    @brief Checks if a value can be stored in a field: fields are limited to EntryStore::maxFieldSize bytes.
+    @param value The value to check.
+    @return True if the value can be stored, false otherwise.
+    */
+    static bool isStorable(std::string_view value);
+    /**
+    @brief Writes all data from password list to the file and clears the journal.
+    */
+    void compact();
+    /**
+    * @brief The writes of a save, taken from the password list by prepareSave() or takeChanges() and carried out by
+    * finishSave(). Splitting a save lets its writes run while the password list is being changed.
+    */
+    struct PendingSave {
+        /**
+         * Whether the vault file is rewritten rather than the journal appended to.
+         */
+        bool rewrite = false;
+        /**
+         * The new contents of the vault file, or the encoded journal records to append.
+         */
+        string data;
+        /**
+         * The layout of the new contents of the vault file, for the saves after this one.
+         */
+        std::optional<BinaryVault::Layout> layout = {};
+    };
+    /**
+    @brief Takes the writes of a save from the password list, in the way of saveData(), or of compact() if asked.
+    A rewrite encrypts the whole password list here, so the writes do not depend on the list anymore.
+    @param compact Whether the journal is to be compacted into the file.
+    @param taken Changes taken by takeChanges() that were not written yet. They are part of the save, ahead of the
+     changes recorded since.
+    @return The writes, to be passed to finishSave().
+    */
+    PendingSave prepareSave(bool compact, string taken = {});
+    /**
+    @brief Takes the changes recorded since the last save, to be appended to the journal. Unlike prepareSave() it
+     never encrypts the whole password list, so its cost only depends on the size of the changes.
+    @return The writes, to be passed to finishSave().
+    */
+    PendingSave takeChanges();
+    /**
+    @brief Carries out the writes of a save. Only the files are touched, so the password list may be used and
+     changed by another thread meanwhile, but saves must be carried out one at a time and in the order they were
+     taken. If the writes fail, the next save rewrites the file.
+    @param save The writes, taken by prepareSave() or takeChanges().
+    @throws std::system_error If the files could not be written.
+    */
+    void finishSave(const PendingSave& save);
+    /**
+    @brief Chooses the codec the records of the file are compressed with. A vault file written with another codec
+     is rewritten by the next save.
+    @param codec The codec to use. Files opened in version 5 or later keep their codec until this is called.
+    */
+    void setCompression(Compression codec);
+    /**
+    @brief Makes the next save rewrite the whole file with a new salt, encoding every category again rather than
+     copying the segments of unchanged ones.
+    */
+    void invalidateLayout();
+    /**
     @brief Checks if an entry with the given name exists in a given category.
     @param name The name of the entry to check.
     @param cat The category in which to search for the entry.
     @return True if the entry exists in the category, false otherwise.
     */
-    bool entryExists(const string& name, const string& cat);
+    bool entryExists(const string& name, const string& cat) const;
+    /**
+    @brief Finds the position of an entry within its category.
+    @param cat The category of the entry.
+    @param name The name of the entry.
+    @return The index of the entry within its category, or -1 if there is no such entry.
+    */
+    int indexInCategory(std::string_view cat, std::string_view name) const;
     /**
     @brief Checks if a given category is empty.
     @return True if the category is empty, false otherwise.
     */
     bool categoryIsEmpty(const string& cat);
+    /**
+    @brief Counts the entries in a category without retrieving them.
+    @param cat The category name.
+    @return The number of entries, or 0 if there is no such category.
+    */
+    std::size_t getEntryCount(const string& cat) const;
 };
 
 
@@ -0,0 +1,73 @@
+#include "PasswordSealer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    /**
+    @brief Overwrites the whole buffer of a string with zeros and empties it.
+    */
+    void wipe(string& text) {
+        // assign reuses the buffer, so the zeros cover every byte the string ever held.
+        text.assign(text.capacity(), '\0');
+        text.clear();
+    }
+}
+
+PasswordSealer::PasswordSealer(std::unique_ptr<CipherEngine> engine, std::uint64_t firstOffset)
+        : engine(std::move(engine)), nextOffset(firstOffset) {}
+
+PasswordSealer::~PasswordSealer() {
+    clearCache();
+}
+
+string PasswordSealer::seal(std::string_view password) {
+    string sealed;
+    sealed.reserve(overhead + password.size());
+    appendSealed(sealed, nextOffset, password);
+    auto encrypted = std::as_writable_bytes(std::span(sealed)).subspan(overhead);
+    engine->apply(encrypted, encrypted, nextOffset);
+    nextOffset += password.size();
+    return sealed;
+}
+
+void PasswordSealer::appendSealed(string &out, std::uint64_t offset, std::string_view encrypted) {
+    for (std::size_t i = 0; i < overhead; ++i) out += static_cast<char>(offset >> (8 * i) & 0xFF);
+    out += encrypted;
+}
+
+std::string_view PasswordSealer::open(std::string_view sealed) const {
+    ++uses;
+    for (auto& slot : cache) {
+        if (slot.sealed == sealed.data()) {
+            slot.lastUse = uses;
+            return slot.plain;
+        }
+    }
+    auto& slot = *std::ranges::min_element(cache, {}, &Slot::lastUse);
+    wipe(slot.plain);
+    openInto(sealed, slot.plain);
+    slot.sealed = sealed.data();
+    slot.lastUse = uses;
+    return slot.plain;
+}
+
+void PasswordSealer::openInto(std::string_view sealed, string &out) const {
+    if (sealed.size() < overhead) throw std::logic_error("Sealed password is too short");
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; i < overhead; ++i) {
+        offset |= static_cast<std::uint64_t>(static_cast<unsigned char>(sealed[i])) << (8 * i);
+    }
+    auto start = out.size();
+    out.append(sealed.substr(overhead));
+    auto plain = std::as_writable_bytes(std::span(out)).subspan(start);
+    engine->apply(plain, plain, offset);
+}
+
+void PasswordSealer::clearCache() const {
+    for (auto& slot : cache) {
+        wipe(slot.plain);
+        slot.sealed = nullptr;
+        slot.lastUse = 0;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PASSWORDMANAGER_PASSWORDSEALER_H
+#define PASSWORDMANAGER_PASSWORDSEALER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include "CipherEngine.h"
+
+using std::string;
+
+/**
+* @brief Class keeping passwords encrypted in memory and decrypting them when they are read.
+* A sealed password is the position of its keystream (8 bytes) followed by the encrypted password. Every password
+* is sealed at a new position of the stream, so no keystream is used twice. The most recently opened passwords are
+* kept decrypted in a small cache, whose copies are wiped when they are evicted.
+* Opening passwords updates the cache, so a sealer must not be used from several threads at once, except for
+* openInto(), which leaves the cache alone and may be called by any number of threads, also while one thread seals.
+*/
+class PasswordSealer {
+public:
+    /**
+     * Number of bytes sealing adds to a password.
+     */
+    static constexpr std::size_t overhead = 8;
+    /**
+     * Number of decrypted passwords kept in the cache.
+     */
+    static constexpr std::size_t cacheSize = 16;
+private:
+    /**
+     * A cached decrypted password, identified by the address of its sealed form.
+     */
+    struct Slot {
+        const char* sealed = nullptr;
+        string plain;
+        std::uint64_t lastUse = 0;
+    };
+    std::unique_ptr<CipherEngine> engine;
+    /**
+     * Position of the stream the next password is sealed at.
+     */
+    std::uint64_t nextOffset;
+    mutable std::array<Slot, cacheSize> cache;
+    mutable std::uint64_t uses = 0;
+public:
+    /**
+    @brief Constructs a PasswordSealer.
+    @param engine The engine passwords are encrypted with.
+    @param firstOffset The position of the stream the first password is sealed at. Everything before it must not
+     be used for anything but passwords already sealed with the same engine.
+    */
+    PasswordSealer(std::unique_ptr<CipherEngine> engine, std::uint64_t firstOffset);
+    PasswordSealer(const PasswordSealer&) = delete;
+    PasswordSealer& operator=(const PasswordSealer&) = delete;
+    ~PasswordSealer();
+    /**
+    @brief Seals a password.
+    @param password The password to seal.
+    @return The sealed password.
+    */
+    string seal(std::string_view password);
+    /**
+    @brief Appends a password that is already encrypted with the engine of the sealer to a string in sealed form.
+    @param out The string to append to.
+    @param offset The position of the stream the password is encrypted at.
+    @param encrypted The encrypted password.
+    */
+    static void appendSealed(string& out, std::uint64_t offset, std::string_view encrypted);
+    /**
+    @brief Decrypts a sealed password through the cache.
+    @param sealed The sealed password. Must stay in place until clearCache() is called.
+    @return The password, valid until cacheSize other passwords were opened or the cache is cleared.
+    */
+    std::string_view open(std::string_view sealed) const;
+    /**
+    @brief Decrypts a sealed password without caching it.
+    @param sealed The sealed password.
+    @param out The string to append the password to.
+    */
+    void openInto(std::string_view sealed, string& out) const;
+    /**
+    @brief Wipes the cache. Must be called before sealed passwords are moved or released.
+    */
+    void clearCache() const;
+};
+
+
+#endif //PASSWORDMANAGER_PASSWORDSEALER_H
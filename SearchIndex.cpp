@@ -0,0 +1,101 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    std::uint32_t trigram(std::string_view text, std::size_t pos) {
+        return static_cast<std::uint32_t>(static_cast<unsigned char>(SearchIndex::toLower(text[pos]))) << 16 |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(SearchIndex::toLower(text[pos + 1]))) << 8 |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(SearchIndex::toLower(text[pos + 2])));
+    }
+}
+
+vector<std::uint32_t> SearchIndex::trigrams(std::span<const std::string_view> fields) {
+    vector<std::uint32_t> result;
+    for (auto field : fields) {
+        for (std::size_t i = 0; i + 3 <= field.size(); ++i) {
+            result.push_back(trigram(field, i));
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void SearchIndex::add(EntryId id, std::span<const std::string_view> fields) {
+    insert(id, trigrams(fields));
+}
+
+void SearchIndex::remove(EntryId id, std::span<const std::string_view> fields) {
+    erase(id, trigrams(fields));
+}
+
+void SearchIndex::update(EntryId id, std::span<const std::string_view> before,
+                         std::span<const std::string_view> after) {
+    auto removed = trigrams(before);
+    auto added = trigrams(after);
+    vector<std::uint32_t> difference;
+    std::set_difference(removed.begin(), removed.end(), added.begin(), added.end(), std::back_inserter(difference));
+    erase(id, difference);
+    difference.clear();
+    std::set_difference(added.begin(), added.end(), removed.begin(), removed.end(), std::back_inserter(difference));
+    insert(id, difference);
+}
+
+void SearchIndex::insert(EntryId id, const vector<std::uint32_t> &keys) {
+    for (auto key : keys) {
+        auto& ids = postings[key];
+        // Entries are mostly added with increasing ids, so appending is the common case.
+        if (ids.empty() || ids.back() < id) {
+            ids.push_back(id);
+        } else {
+            ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+        }
+    }
+}
+
+void SearchIndex::erase(EntryId id, const vector<std::uint32_t> &keys) {
+    for (auto key : keys) {
+        auto list = postings.find(key);
+        if (list == postings.end()) continue;
+        auto& ids = list->second;
+        auto position = std::lower_bound(ids.begin(), ids.end(), id);
+        if (position != ids.end() && *position == id) ids.erase(position);
+        if (ids.empty()) postings.erase(list);
+    }
+}
+
+vector<EntryId> SearchIndex::candidates(std::string_view query) const {
+    vector<const vector<EntryId>*> lists;
+    for (auto key : trigrams(std::span(&query, 1))) {
+        auto list = postings.find(key);
+        if (list == postings.end()) return {};
+        lists.push_back(&list->second);
+    }
+    if (lists.empty()) return {};
+    // Intersecting from the shortest list keeps the working set as small as possible.
+    std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+    vector<EntryId> result = *lists.front();
+    for (std::size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        const auto& ids = *lists[i];
+        std::erase_if(result, [&](EntryId id) { return !std::binary_search(ids.begin(), ids.end(), id); });
+    }
+    return result;
+}
+
+void SearchIndex::clear() {
+    postings.clear();
+}
+
+std::optional<SearchMatch::Kind> SearchIndex::match(std::string_view field, std::string_view query, SearchMode mode) {
+    auto equal = [](char f, char q) { return toLower(f) == q; };
+    if (field.size() < query.size()) return std::nullopt;
+    if (std::equal(field.begin(), field.begin() + query.size(), query.begin(), equal)) {
+        return field.size() == query.size() ? SearchMatch::Kind::Exact : SearchMatch::Kind::Prefix;
+    }
+    if (mode == SearchMode::Substring &&
+        std::search(field.begin() + 1, field.end(), query.begin(), query.end(), equal) != field.end()) {
+        return SearchMatch::Kind::Substring;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,137 @@
+#ifndef PASSWORDMANAGER_SEARCHINDEX_H
+#define PASSWORDMANAGER_SEARCHINDEX_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "EntryStore.h"
+
+using std::vector;
+
+/**
+ * How a search query has to match a field.
+ */
+enum class SearchMode {
+    Substring, Prefix
+};
+
+/**
+ * An entry found by a search, with the field that matched the query best.
+ */
+struct SearchMatch {
+    /**
+     * How closely a field matches the query, from the best to the worst.
+     */
+    enum class Kind {
+        Exact, Prefix, Substring
+    };
+    EntryRef entry;
+    EntryField field;
+    Kind kind;
+    /**
+    @brief Computes the rank of a match given by its kind and field, see rank().
+    @param kind How closely the field matches the query.
+    @param field The field that matched.
+    @return The rank.
+    */
+    static auto rankOf(Kind kind, EntryField field) {
+        return std::tuple(kind, field != EntryField::Name, field != EntryField::Website, field != EntryField::Login);
+    }
+    /**
+    @brief Retrieves the position of the match in search results: matches are ordered by how closely the query
+     matches (exact, then prefix, then substring) and then by the field that matched (name, then website, then
+     login, then category). Smaller ranks come first.
+    @return The rank, to be compared with the ranks of other matches.
+    */
+    auto rank() const {
+        return rankOf(kind, field);
+    }
+};
+
+/**
+* @brief Class representing a trigram inverted index used for full-text search.
+* Every field added to the index is split into overlapping sequences of 3 characters (trigrams), ignoring case.
+* For every trigram the index keeps the sorted ids of the entries containing it. A query is answered by
+* intersecting the lists of its trigrams, which yields a small set of candidates that contain every trigram
+* of the query. The candidates still have to be checked against the query, since having all its trigrams
+* does not guarantee that an entry contains the query itself.
+*/
+class SearchIndex {
+    /**
+     * Map of trigrams to the sorted ids of the entries containing them.
+     */
+    std::unordered_map<std::uint32_t, vector<EntryId>> postings;
+    /**
+    @brief Collects the distinct trigrams of the given fields.
+    @param fields The fields to split.
+    @return The sorted trigrams without duplicates.
+    */
+    static vector<std::uint32_t> trigrams(std::span<const std::string_view> fields);
+    /**
+    @brief Adds an id to the lists of the given trigrams.
+    */
+    void insert(EntryId id, const vector<std::uint32_t>& keys);
+    /**
+    @brief Removes an id from the lists of the given trigrams.
+    */
+    void erase(EntryId id, const vector<std::uint32_t>& keys);
+public:
+    /**
+     * Length of the shortest query the index can answer.
+     */
+    static constexpr std::size_t minQueryLength = 3;
+    /**
+    @brief Adds an entry to the index.
+    @param id The id of the entry.
+    @param fields The searchable fields of the entry.
+    */
+    void add(EntryId id, std::span<const std::string_view> fields);
+    /**
+    @brief Removes an entry from the index.
+    @param id The id of the entry.
+    @param fields The searchable fields of the entry, as they were when it was added.
+    */
+    void remove(EntryId id, std::span<const std::string_view> fields);
+    /**
+    @brief Updates an entry whose fields have changed. Only the trigrams that appear in just one of the versions
+     are touched, so changing one field does not rewrite the long lists shared by most entries.
+    @param id The id of the entry.
+    @param before The searchable fields of the entry before the change.
+    @param after The searchable fields of the entry after the change.
+    */
+    void update(EntryId id, std::span<const std::string_view> before, std::span<const std::string_view> after);
+    /**
+    @brief Finds the entries that may contain the query.
+    @param query The text to look for. Must be at least minQueryLength characters long.
+    @return The sorted ids of the entries containing every trigram of the query.
+    */
+    vector<EntryId> candidates(std::string_view query) const;
+    /**
+    @brief Removes all entries from the index.
+    */
+    void clear();
+    /**
+    @brief Checks how a field matches a query, ignoring case.
+    @param field The field to check.
+    @param query The query, already converted to lower case.
+    @param mode How the query has to match the field.
+    @return The kind of the match, or an empty optional if the field does not match.
+    */
+    static std::optional<SearchMatch::Kind> match(std::string_view field, std::string_view query, SearchMode mode);
+    /**
+    @brief Converts an ASCII character to lower case.
+    @param c The character to convert.
+    @return The lower case character.
+    */
+    static char toLower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+};
+
+
+#endif //PASSWORDMANAGER_SEARCHINDEX_H
@@ -0,0 +1,130 @@
+#include "Sha256.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+    constexpr std::array<std::uint32_t, 64> roundConstants = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+}
+
+Sha256::Sha256() : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab,
+                         0x5be0cd19} {}
+
+void Sha256::compress(const std::byte *data) {
+    std::array<std::uint32_t, 64> w;
+    for (int i = 0; i < 16; ++i) {
+        w[i] = 0;
+        for (int k = 0; k < 4; ++k) {
+            w[i] = w[i] << 8 | std::to_integer<std::uint32_t>(data[4 * i + k]);
+        }
+    }
+    for (int i = 16; i < 64; ++i) {
+        auto s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    auto [a, b, c, d, e, f, g, h] = state;
+    for (int i = 0; i < 64; ++i) {
+        auto t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                  roundConstants[i] + w[i];
+        auto t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void Sha256::update(std::span<const std::byte> data) {
+    totalBytes += data.size();
+    if (blockUsed > 0) {
+        auto count = std::min(data.size(), block.size() - blockUsed);
+        std::copy_n(data.begin(), count, block.begin() + blockUsed);
+        blockUsed += count;
+        data = data.subspan(count);
+        if (blockUsed < block.size()) return;
+        compress(block.data());
+        blockUsed = 0;
+    }
+    for (; data.size() >= block.size(); data = data.subspan(block.size())) {
+        compress(data.data());
+    }
+    std::copy(data.begin(), data.end(), block.begin());
+    blockUsed = data.size();
+}
+
+void Sha256::update(std::string_view text) {
+    update(std::as_bytes(std::span(text)));
+}
+
+Sha256::Digest Sha256::finish() {
+    auto bits = totalBytes * 8;
+    // Pad with a single 1 bit, then zeros, leaving room for the length in the last 8 bytes.
+    block[blockUsed++] = std::byte{0x80};
+    if (blockUsed > block.size() - 8) {
+        std::fill(block.begin() + blockUsed, block.end(), std::byte{0});
+        compress(block.data());
+        blockUsed = 0;
+    }
+    std::fill(block.begin() + blockUsed, block.end() - 8, std::byte{0});
+    for (int i = 0; i < 8; ++i) {
+        block[block.size() - 1 - i] = static_cast<std::byte>(bits >> (8 * i));
+    }
+    compress(block.data());
+    Digest digest;
+    for (std::size_t i = 0; i < state.size(); ++i) {
+        for (int k = 0; k < 4; ++k) {
+            digest[4 * i + k] = static_cast<std::byte>(state[i] >> (24 - 8 * k));
+        }
+    }
+    return digest;
+}
+
+Sha256::Digest Sha256::hash(std::span<const std::byte> data) {
+    Sha256 sha;
+    sha.update(data);
+    return sha.finish();
+}
+
+Sha256::Digest Sha256::hmac(std::span<const std::byte> key, std::span<const std::byte> message) {
+    // Keys longer than a block are hashed first; shorter keys are padded with zeros.
+    std::array<std::byte, 64> padded{};
+    if (key.size() > padded.size()) {
+        auto digest = hash(key);
+        std::copy(digest.begin(), digest.end(), padded.begin());
+    } else {
+        std::copy(key.begin(), key.end(), padded.begin());
+    }
+    auto pad = [&](std::byte value) {
+        auto block = padded;
+        for (auto& byte : block) byte ^= value;
+        return block;
+    };
+    Sha256 inner;
+    inner.update(pad(std::byte{0x36}));
+    inner.update(message);
+    auto innerDigest = inner.finish();
+    Sha256 outer;
+    outer.update(pad(std::byte{0x5c}));
+    outer.update(innerDigest);
+    return outer.finish();
+}
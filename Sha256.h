@@ -0,0 +1,62 @@
+#ifndef PASSWORDMANAGER_SHA256_H
+#define PASSWORDMANAGER_SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/**
+* @brief Class computing SHA-256 digests (FIPS 180-4) incrementally, and HMACs based on them.
+*/
+class Sha256 {
+public:
+    /**
+     * Size of a digest in bytes.
+     */
+    static constexpr std::size_t digestSize = 32;
+    using Digest = std::array<std::byte, digestSize>;
+private:
+    std::array<std::uint32_t, 8> state;
+    std::array<std::byte, 64> block{};
+    std::size_t blockUsed = 0;
+    std::uint64_t totalBytes = 0;
+    /**
+    @brief Mixes a full 64-byte block into the state.
+    */
+    void compress(const std::byte* data);
+public:
+    Sha256();
+    /**
+    @brief Adds data to the digest.
+    @param data The data to add.
+    */
+    void update(std::span<const std::byte> data);
+    /**
+    @brief Adds text to the digest.
+    @param text The text to add.
+    */
+    void update(std::string_view text);
+    /**
+    @brief Completes the digest. The object must not be used afterwards.
+    @return The digest of all data added.
+    */
+    Digest finish();
+    /**
+    @brief Computes the digest of a single piece of data.
+    @param data The data to hash.
+    @return The digest.
+    */
+    static Digest hash(std::span<const std::byte> data);
+    /**
+    @brief Computes the HMAC-SHA-256 (RFC 2104) of a message.
+    @param key The secret key.
+    @param message The message to authenticate.
+    @return The authentication code.
+    */
+    static Digest hmac(std::span<const std::byte> key, std::span<const std::byte> message);
+};
+
+
+#endif //PASSWORDMANAGER_SHA256_H
@@ -0,0 +1,161 @@
+#include "SharedPasswordList.h"
+#include "Stats.h"
+
+namespace {
+    /**
+    @brief Copies the entries of a category of a snapshot, to be changed into a new category.
+    */
+    vector<std::shared_ptr<const Entry>> entriesOf(const VaultSnapshot& snapshot, std::string_view cat) {
+        auto category = snapshot.stored().find(cat);
+        if (category == snapshot.stored().end()) return {};
+        return category->second->stored();
+    }
+
+    std::shared_ptr<const VaultSnapshot::Category> makeCategory(vector<std::shared_ptr<const Entry>> entries) {
+        return std::make_shared<const VaultSnapshot::Category>(std::move(entries));
+    }
+}
+
+SharedPasswordList::SharedPasswordList(PasswordList &list, PasswordStorage storage) : list(list) {
+    if (storage == PasswordStorage::Sealed) {
+        // The random salt alone makes the key, which never leaves the memory of the process.
+        sealer = std::make_shared<PasswordSealer>(CipherEngine::create(CipherParams::generate(), ""), 0);
+    }
+    refresh();
+}
+
+std::shared_ptr<const Entry> SharedPasswordList::store(const Entry &entry) {
+    if (!sealer) return std::make_shared<const Entry>(entry);
+    return std::make_shared<const Entry>(entry.getCategory(), entry.getName(), sealer->seal(entry.getPassword()),
+                                         entry.getLogin(), entry.getWebsite());
+}
+
+std::shared_ptr<const VaultSnapshot::Category> SharedPasswordList::copyCategory(const string &cat) {
+    vector<std::shared_ptr<const Entry>> entries;
+    for (const auto& entry : list.getEntriesInCategory(cat)) {
+        entries.push_back(store(entry));
+    }
+    return makeCategory(std::move(entries));
+}
+
+void SharedPasswordList::publish(VaultSnapshot::Categories categories) {
+    auto number = published.load(std::memory_order_relaxed) + 1;
+    auto next = std::make_shared<const VaultSnapshot>(std::move(categories), sealer, number);
+    {
+        std::lock_guard guard(mutex);
+        current.swap(next);
+    }
+    // The number follows the snapshot, so a reader that sees it finds a snapshot at least as recent.
+    published.store(number, std::memory_order_release);
+}
+
+void SharedPasswordList::publish(
+        std::initializer_list<std::pair<std::string_view, std::shared_ptr<const VaultSnapshot::Category>>> changed) {
+    STATS_TIMER(timer, "SharedPasswordList::publish");
+    // The other categories are shared with the latest snapshot rather than copied.
+    auto categories = current->stored();
+    for (const auto& [name, category] : changed) {
+        if (category) {
+            categories.insert_or_assign(string(name), category);
+        } else if (auto iterator = categories.find(name); iterator != categories.end()) {
+            categories.erase(iterator);
+        }
+    }
+    publish(std::move(categories));
+}
+
+void SharedPasswordList::publishMove(const string &category, std::size_t index, const string &newCat) {
+    auto entries = entriesOf(*current, category);
+    Entry moved = *entries[index];
+    moved.setCategory(newCat);
+    entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(index));
+    if (newCat == category) {
+        entries.push_back(std::make_shared<const Entry>(std::move(moved)));
+        publish({{category, makeCategory(std::move(entries))}});
+        return;
+    }
+    auto target = entriesOf(*current, newCat);
+    target.push_back(std::make_shared<const Entry>(std::move(moved)));
+    publish({{category, makeCategory(std::move(entries))}, {newCat, makeCategory(std::move(target))}});
+}
+
+std::shared_ptr<const VaultSnapshot> SharedPasswordList::snapshot() const {
+    std::lock_guard guard(mutex);
+    return current;
+}
+
+std::uint64_t SharedPasswordList::version() const {
+    return published.load(std::memory_order_acquire);
+}
+
+void SharedPasswordList::renew(std::shared_ptr<const VaultSnapshot> &snapshot) const {
+    if (!snapshot || snapshot->version() != version()) snapshot = this->snapshot();
+}
+
+PasswordList &SharedPasswordList::writer() {
+    return list;
+}
+
+void SharedPasswordList::addEntry(const Entry &entry) {
+    list.addEntry(entry);
+    auto entries = entriesOf(*current, entry.getCategory());
+    entries.push_back(store(entry));
+    publish({{entry.getCategory(), makeCategory(std::move(entries))}});
+}
+
+void SharedPasswordList::removeEntry(const string &category, int index) {
+    list.removeEntry(category, index);
+    auto entries = entriesOf(*current, category);
+    entries.erase(entries.begin() + index);
+    publish({{category, makeCategory(std::move(entries))}});
+}
+
+void SharedPasswordList::addCategory(const string &cat) {
+    list.addCategory(cat);
+    if (!current->stored().contains(cat)) publish({{cat, makeCategory({})}});
+}
+
+void SharedPasswordList::removeCategory(const string &category) {
+    list.removeCategory(category);
+    if (current->stored().contains(category)) publish({{category, nullptr}});
+}
+
+void SharedPasswordList::moveEntry(const string &newCat, const Entry &entry) {
+    auto index = list.indexInCategory(entry.getCategory(), entry.getName());
+    if (index < 0) return;
+    list.moveEntry(newCat, entry);
+    publishMove(entry.getCategory(), static_cast<std::size_t>(index), newCat);
+}
+
+void SharedPasswordList::editEntry(const string &category, int index, EntryField field, const string &value) {
+    list.editEntry(category, index, field, value);
+    if (field == EntryField::Category) {
+        publishMove(category, static_cast<std::size_t>(index), value);
+        return;
+    }
+    auto entries = entriesOf(*current, category);
+    Entry edited = *entries[index];
+    edited.setField(field, field == EntryField::Password && sealer ? sealer->seal(value) : value);
+    entries[index] = std::make_shared<const Entry>(std::move(edited));
+    publish({{category, makeCategory(std::move(entries))}});
+}
+
+ImportResult SharedPasswordList::importEntries(std::istream &input, ExchangeFormat format) {
+    try {
+        auto result = list.importEntries(input, format);
+        refresh();
+        return result;
+    } catch (...) {
+        refresh();
+        throw;
+    }
+}
+
+void SharedPasswordList::refresh() {
+    STATS_TIMER(timer, "SharedPasswordList::refresh");
+    VaultSnapshot::Categories categories;
+    for (const auto& cat : list.getCategories()) {
+        categories.emplace(cat, copyCategory(cat));
+    }
+    publish(std::move(categories));
+}
@@ -0,0 +1,164 @@
+#ifndef PASSWORDMANAGER_SHAREDPASSWORDLIST_H
+#define PASSWORDMANAGER_SHAREDPASSWORDLIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "PasswordList.h"
+#include "PasswordSealer.h"
+#include "VaultSnapshot.h"
+
+using std::string;
+
+/**
+* @brief Class letting any number of threads read a password list while a single thread changes it.
+* Readers never touch the password list: they take the latest VaultSnapshot, an immutable copy of the entries, and
+* read it without any lock for as long as they keep it. The writer changes the password list through this class,
+* which then publishes a new snapshot by swapping the shared pointer to the latest one and raising an atomic version.
+* Only the categories a change touches are copied into the new snapshot; a snapshot is freed once the last reader
+* releases it. A reader keeping a snapshot passes it to renew(), which only takes the latest one when the version
+* changed, so reads do not contend on a lock or on the count of a shared pointer.
+* All functions but snapshot() and version() are for the writer, and must not be called by two threads at once.
+* Saving the password list is left to the writer, which may use a BackgroundSaver as usual.
+*/
+class SharedPasswordList {
+    PasswordList& list;
+    /**
+     * The sealer of the passwords in the snapshots, or nullptr if they are stored as they are. Snapshots share it,
+     * so it lives as long as the last of them. Only the writer seals with it; readers only open passwords.
+     */
+    std::shared_ptr<PasswordSealer> sealer;
+    /**
+     * Guards the pointer to the latest snapshot, only for as long as it is copied or swapped. The atomic shared
+     * pointer of libstdc++ 12 unlocks loads with relaxed ordering, which does not order them before the next store.
+     */
+    mutable std::mutex mutex;
+    /**
+     * The latest snapshot.
+     */
+    std::shared_ptr<const VaultSnapshot> current;
+    /**
+     * The number of the latest snapshot, readable without touching the shared pointer.
+     */
+    std::atomic<std::uint64_t> published = 0;
+    /**
+    @brief Copies an entry to be stored in a snapshot, sealing its password.
+    @param entry The entry with its password in plain text.
+    @return The copy.
+    */
+    std::shared_ptr<const Entry> store(const Entry& entry);
+    /**
+    @brief Copies the entries of a category of the password list into a new category of a snapshot.
+    @param cat The category name.
+    @return The category.
+    */
+    std::shared_ptr<const VaultSnapshot::Category> copyCategory(const string& cat);
+    /**
+    @brief Publishes a snapshot in which an entry of the latest snapshot is moved to the end of a category, after it
+     was moved in the password list.
+    @param category The category of the entry.
+    @param index The index of the entry within its category.
+    @param newCat The new category for the entry, which may be the same.
+    */
+    void publishMove(const string& category, std::size_t index, const string& newCat);
+    /**
+    @brief Publishes a snapshot holding the given categories.
+    @param categories The categories of the snapshot.
+    */
+    void publish(VaultSnapshot::Categories categories);
+    /**
+    @brief Publishes a snapshot in which the given categories of the latest snapshot are replaced.
+    @param changed The categories to replace, each with its new entries, or with null if it was removed.
+    */
+    void publish(std::initializer_list<std::pair<std::string_view, std::shared_ptr<const VaultSnapshot::Category>>>
+                 changed);
+public:
+    /**
+    @brief Constructs a SharedPasswordList and publishes the first snapshot of the password list.
+    @param list The password list. Must outlive this object, and only be changed through it from now on.
+    @param storage How passwords are kept in the snapshots. Sealed passwords are sealed with a key of their own.
+    */
+    explicit SharedPasswordList(PasswordList& list, PasswordStorage storage = PasswordStorage::Sealed);
+    SharedPasswordList(const SharedPasswordList&) = delete;
+    SharedPasswordList& operator=(const SharedPasswordList&) = delete;
+    /**
+    @brief Retrieves the latest snapshot. Safe to call from any thread, also while the writer changes the list.
+    @return The snapshot, which stays valid and unchanged for as long as it is kept.
+    */
+    std::shared_ptr<const VaultSnapshot> snapshot() const;
+    /**
+    @brief Retrieves the number of the latest snapshot, so a reader keeping a snapshot can check if it is outdated
+     without taking a new one. Safe to call from any thread.
+    @return The number of the latest snapshot.
+    */
+    std::uint64_t version() const;
+    /**
+    @brief Replaces a kept snapshot by the latest one if it is outdated. Safe to call from any thread; a current
+     snapshot is kept without taking any lock.
+    @param snapshot The kept snapshot, or null to take the latest one.
+    */
+    void renew(std::shared_ptr<const VaultSnapshot>& snapshot) const;
+    /**
+    @brief Retrieves the password list, for the writer to save it or to read it directly.
+     A change made to it directly is only published by refresh().
+    @return The password list.
+    */
+    PasswordList& writer();
+    /**
+    @brief Adds an entry, in the way of PasswordList::addEntry, and publishes the change.
+    @param entry The entry to be added.
+    */
+    void addEntry(const Entry& entry);
+    /**
+    @brief Removes an entry, in the way of PasswordList::removeEntry, and publishes the change.
+    @param category The category of the entry.
+    @param index The index of the entry within its category.
+    */
+    void removeEntry(const string& category, int index);
+    /**
+    @brief Adds a category, in the way of PasswordList::addCategory, and publishes the change.
+    @param cat The category name to add.
+    */
+    void addCategory(const string& cat);
+    /**
+    @brief Removes a category, in the way of PasswordList::removeCategory, and publishes the change.
+    @param category The category name to remove.
+    */
+    void removeCategory(const string& category);
+    /**
+    @brief Moves an entry to a new category, in the way of PasswordList::moveEntry, and publishes the change.
+    @param newCat The new category for the entry.
+    @param entry The entry to be moved.
+    */
+    void moveEntry(const string& newCat, const Entry& entry);
+    /**
+    @brief Changes a field of an entry, in the way of PasswordList::editEntry, and publishes the change.
+    @param category The category of the entry.
+    @param index The index of the entry within its category.
+    @param field The field to change.
+    @param value The new value of the field.
+    */
+    void editEntry(const string& category, int index, EntryField field, const string& value);
+    /**
+    @brief Adds the entries read from a stream, in the way of PasswordList::importEntries, and publishes them.
+    @param input The stream to read from.
+    @param format The format of the stream.
+    @return The counts of added and skipped entries.
+    @throws std::runtime_error If the stream is malformed. The entries read before the error are published.
+    */
+    ImportResult importEntries(std::istream& input, ExchangeFormat format);
+    /**
+    @brief Publishes a snapshot copied from the whole password list, after it was changed directly.
+    */
+    void refresh();
+};
+
+
+#endif //PASSWORDMANAGER_SHAREDPASSWORDLIST_H
@@ -0,0 +1,42 @@
+#include "SortedIndex.h"
+#include <algorithm>
+
+bool SortedIndex::Order::operator()(EntryId a, EntryId b) const {
+    for (auto field : {first, second}) {
+        auto left = store->field(a, field);
+        auto right = store->field(b, field);
+        if (left != right) return left < right;
+    }
+    return a < b;
+}
+
+SortedIndex::SortedIndex(const EntryStore &store, EntryField first, EntryField second)
+        : ids(Order{&store, first, second}) {}
+
+void SortedIndex::add(vector<EntryId> entries) {
+    std::sort(entries.begin(), entries.end(), ids.key_comp());
+    // Inserting in order appends every id next to the previous one.
+    for (auto id : entries) {
+        ids.insert(ids.end(), id);
+    }
+}
+
+void SortedIndex::add(EntryId id) {
+    ids.insert(id);
+}
+
+void SortedIndex::remove(EntryId id) {
+    ids.erase(id);
+}
+
+bool SortedIndex::covers(EntryField field) const {
+    return ids.key_comp().first == field || ids.key_comp().second == field;
+}
+
+SortedIndex::const_iterator SortedIndex::begin() const {
+    return ids.begin();
+}
+
+SortedIndex::const_iterator SortedIndex::end() const {
+    return ids.end();
+}
@@ -0,0 +1,62 @@
+#ifndef PASSWORDMANAGER_SORTEDINDEX_H
+#define PASSWORDMANAGER_SORTEDINDEX_H
+
+#include <set>
+#include "EntryStore.h"
+
+/**
+* @brief Class representing the entries of a password list ordered by two fields.
+* The order is the one of Entry::compareEntries, with ties broken by entry id so every entry has a fixed place.
+* The index only stores ids and reads the fields from the entry store when comparing, so an entry has to be
+* removed from the index before one of its sort fields changes and added back afterwards.
+*/
+class SortedIndex {
+    /**
+     * Comparison of entries by the two fields of the index.
+     */
+    struct Order {
+        const EntryStore* store;
+        EntryField first;
+        EntryField second;
+        bool operator()(EntryId a, EntryId b) const;
+    };
+    /**
+     * The ids of the indexed entries, in order.
+     */
+    std::set<EntryId, Order> ids;
+public:
+    using const_iterator = std::set<EntryId, Order>::const_iterator;
+    /**
+    @brief Constructs an empty SortedIndex.
+    @param store The store holding the entries.
+    @param first The field to sort by.
+    @param second The field to sort entries with an equal first field by.
+    */
+    SortedIndex(const EntryStore& store, EntryField first, EntryField second);
+    /**
+    @brief Adds entries to the index. Sorting them up front lets the index be built in linear time.
+    @param entries The ids of the entries.
+    */
+    void add(vector<EntryId> entries);
+    /**
+    @brief Adds an entry to the index.
+    @param id The id of the entry.
+    */
+    void add(EntryId id);
+    /**
+    @brief Removes an entry from the index.
+    @param id The id of the entry.
+    */
+    void remove(EntryId id);
+    /**
+    @brief Checks if the order of the index depends on a field.
+    @param field The field to check.
+    @return True if the index sorts by the field, false otherwise.
+    */
+    bool covers(EntryField field) const;
+    const_iterator begin() const;
+    const_iterator end() const;
+};
+
+
+#endif //PASSWORDMANAGER_SORTEDINDEX_H
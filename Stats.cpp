@@ -0,0 +1,132 @@
+#include "Stats.h"
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+namespace {
+    /**
+     * The time the program started. The statistics are only created by the first operation recorded, which may
+     * have started earlier.
+     */
+    const auto programStart = std::chrono::steady_clock::now();
+}
+
+Stats::Timer::Timer(const char *name) : name(name), start(std::chrono::steady_clock::now()) {}
+
+Stats::Timer::~Timer() {
+    Stats::instance().record(name, start, std::chrono::steady_clock::now() - start, bytes);
+}
+
+void Stats::Timer::addBytes(std::size_t count) {
+    bytes += count;
+}
+
+Stats::Stats() : origin(programStart) {
+    auto report = std::getenv("PASSWORDMANAGER_STATS");
+    reportAtExit = report != nullptr && *report != '\0';
+    if (auto trace = std::getenv("PASSWORDMANAGER_TRACE")) traceFileName = trace;
+}
+
+Stats::~Stats() {
+    if (reportAtExit) std::cerr << report();
+    if (!traceFileName.empty()) {
+        try {
+            writeTrace(traceFileName);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+}
+
+Stats &Stats::instance() {
+    static Stats stats;
+    return stats;
+}
+
+std::size_t Stats::bucket(std::uint64_t nanoseconds) {
+    if (nanoseconds < bucketsPerPower) return nanoseconds;
+    // The position of the highest bit picks the power of 2, the next 2 bits the quarter within it.
+    auto power = static_cast<std::size_t>(std::bit_width(nanoseconds) - 1);
+    auto quarter = static_cast<std::size_t>(nanoseconds >> (power - 2) & (bucketsPerPower - 1));
+    return power * bucketsPerPower + quarter;
+}
+
+double Stats::Histogram::percentile(double rank) const {
+    if (count == 0) return 0;
+    auto target = static_cast<std::uint64_t>(rank / 100 * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen < target) continue;
+        if (i < bucketsPerPower) return static_cast<double>(i);
+        // Report the middle of the bucket.
+        auto power = i / bucketsPerPower;
+        auto lower = static_cast<double>((bucketsPerPower + i % bucketsPerPower) << (power - 2));
+        return std::min(lower * (1 + 0.5 / static_cast<double>(bucketsPerPower + i % bucketsPerPower)),
+                        static_cast<double>(maxNanoseconds));
+    }
+    return static_cast<double>(maxNanoseconds);
+}
+
+void Stats::record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration,
+                   std::size_t bytes) {
+    auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+    std::lock_guard lock(mutex);
+    auto iterator = operations.find(std::string_view(name));
+    if (iterator == operations.end()) iterator = operations.emplace(name, Histogram()).first;
+    auto& histogram = iterator->second;
+    ++histogram.count;
+    histogram.bytes += bytes;
+    histogram.totalNanoseconds += nanoseconds;
+    histogram.maxNanoseconds = std::max(histogram.maxNanoseconds, nanoseconds);
+    ++histogram.buckets[bucket(nanoseconds)];
+    if (!traceFileName.empty() && events.size() < maxEvents) {
+        events.push_back({name, std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count(),
+                          std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), bytes,
+                          std::hash<std::thread::id>()(std::this_thread::get_id())});
+    }
+}
+
+string Stats::report() const {
+    if (!enabled) return "Statistics are not recorded by this build.\n";
+    std::lock_guard lock(mutex);
+    std::ostringstream out;
+    auto milliseconds = [](double nanoseconds) { return nanoseconds / 1e6; };
+    out << std::left << std::setw(32) << "operation" << std::right << std::setw(8) << "count" << std::setw(14)
+        << "bytes" << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+        << std::setw(12) << "max ms" << "\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& [name, histogram] : operations) {
+        out << std::left << std::setw(32) << name << std::right << std::setw(8) << histogram.count << std::setw(14)
+            << histogram.bytes << std::setw(12)
+            << milliseconds(static_cast<double>(histogram.totalNanoseconds) / static_cast<double>(histogram.count))
+            << std::setw(12) << milliseconds(histogram.percentile(50)) << std::setw(12)
+            << milliseconds(histogram.percentile(99)) << std::setw(12)
+            << milliseconds(static_cast<double>(histogram.maxNanoseconds)) << "\n";
+    }
+    return out.str();
+}
+
+void Stats::writeTrace(const string &fileName) const {
+    std::lock_guard lock(mutex);
+    std::ofstream file(fileName);
+    if (!file) throw std::system_error(errno, std::generic_category(), "Failed to open " + fileName);
+    // Thread ids are hashes, which the viewer cannot show as lanes, so they are numbered in order of appearance.
+    std::map<std::size_t, std::size_t> threads;
+    file << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const auto& event = events[i];
+        auto thread = threads.emplace(event.thread, threads.size() + 1).first->second;
+        file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+             << thread << ",\"ts\":" << event.startMicroseconds << ",\"dur\":" << event.durationMicroseconds
+             << ",\"args\":{\"bytes\":" << event.bytes << "}}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    if (!file.flush()) throw std::system_error(errno, std::generic_category(), "Failed to write " + fileName);
+}
@@ -0,0 +1,152 @@
+#ifndef PASSWORDMANAGER_STATS_H
+#define PASSWORDMANAGER_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string, std::vector;
+
+/**
+* @brief Class collecting counters and latency histograms of the instrumented operations.
+* Operations are timed with Stats::Timer through the STATS_TIMER and STATS_BYTES macros, which compile to nothing
+* unless PASSWORDMANAGER_STATS is defined. At exit, the report is printed to the standard error if the
+* PASSWORDMANAGER_STATS environment variable is set, and every timed operation is written in the Chrome
+* trace event format to the file named by the PASSWORDMANAGER_TRACE environment variable.
+*/
+class Stats {
+public:
+    /**
+    * @brief Times the scope it lives in and records it when it is destroyed.
+    */
+    class Timer {
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+        std::size_t bytes = 0;
+    public:
+        /**
+        @brief Starts timing an operation.
+        @param name The name of the operation. Must be a string literal.
+        */
+        explicit Timer(const char* name);
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+        /**
+        @brief Adds to the number of bytes processed by the operation.
+        @param count The number of bytes.
+        */
+        void addBytes(std::size_t count);
+    };
+    /**
+     * Whether the program was built with the instrumentation.
+     */
+#ifdef PASSWORDMANAGER_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+private:
+    /**
+     * Latencies are counted in buckets of 4 per power of 2 nanoseconds, so percentiles are accurate to about 20%.
+     */
+    static constexpr std::size_t bucketsPerPower = 4;
+    /**
+     * Counters and latency histogram of one operation.
+     */
+    struct Histogram {
+        std::uint64_t count = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t totalNanoseconds = 0;
+        std::uint64_t maxNanoseconds = 0;
+        std::array<std::uint64_t, 64 * bucketsPerPower> buckets{};
+        /**
+        @brief Estimates a percentile of the recorded latencies.
+        @param rank The percentile, between 0 and 100.
+        @return The latency in nanoseconds.
+        */
+        double percentile(double rank) const;
+    };
+    /**
+     * An operation recorded for the trace file.
+     */
+    struct Event {
+        const char* name;
+        std::int64_t startMicroseconds;
+        std::int64_t durationMicroseconds;
+        std::size_t bytes;
+        std::size_t thread;
+    };
+    /**
+     * Most events kept for the trace file, so a long session cannot use up the memory.
+     */
+    static constexpr std::size_t maxEvents = 1 << 20;
+    mutable std::mutex mutex;
+    std::map<string, Histogram, std::less<>> operations;
+    vector<Event> events;
+    /**
+     * The file the trace is written to at exit, or empty if no trace is recorded.
+     */
+    string traceFileName;
+    /**
+     * Whether the report is printed at exit.
+     */
+    bool reportAtExit;
+    /**
+     * The time trace timestamps are relative to, the start of the program.
+     */
+    std::chrono::steady_clock::time_point origin;
+    Stats();
+    /**
+    @brief Maps a latency to its histogram bucket.
+    */
+    static std::size_t bucket(std::uint64_t nanoseconds);
+public:
+    /**
+    @brief Prints the report and writes the trace file if the environment asked for them.
+    */
+    ~Stats();
+    /**
+    @brief Retrieves the statistics of the program.
+    @return The statistics.
+    */
+    static Stats& instance();
+    /**
+    @brief Records a timed operation.
+    @param name The name of the operation. Must be a string literal.
+    @param start The time the operation started.
+    @param duration The duration of the operation.
+    @param bytes The number of bytes processed by the operation.
+    */
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration,
+                std::size_t bytes);
+    /**
+    @brief Formats the counters and latency percentiles of every operation as a table.
+    @return The report.
+    */
+    string report() const;
+    /**
+    @brief Writes the recorded operations in the Chrome trace event format, viewable in chrome://tracing or Perfetto.
+    @param fileName The file to write.
+    @throws std::system_error If the file could not be written.
+    */
+    void writeTrace(const string& fileName) const;
+};
+
+#ifdef PASSWORDMANAGER_STATS
+#define STATS_TIMER(timer, name) Stats::Timer timer(name)
+#define STATS_BYTES(timer, count) timer.addBytes(count)
+#else
+#define STATS_TIMER(timer, name) ((void) 0)
+#define STATS_BYTES(timer, count) ((void) 0)
+#endif
+
+
+#endif //PASSWORDMANAGER_STATS_H
@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <utility>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t)> &task) {
+    if (count == 0) return;
+    // Helpers may only start after run() has returned, so everything they touch is shared rather than local.
+    // They only call the task after claiming an index, which cannot happen once all indexes are done.
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::size_t count;
+        const std::function<void(std::size_t)>* task;
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->task = &task;
+    auto drain = [state] {
+        for (std::size_t i; (i = state->next++) < state->count;) {
+            try {
+                (*state->task)(i);
+            } catch (...) {
+                std::lock_guard lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            if (++state->done == state->count) state->done.notify_all();
+        }
+    };
+    for (std::size_t i = 0; i < std::min(count - 1, workers.size()); ++i) {
+        post(drain);
+    }
+    drain();
+    for (auto done = state->done.load(); done < count; done = state->done.load()) {
+        state->done.wait(done);
+    }
+    // The exception is taken out of the shared state so the caller holds the last reference to it.
+    if (auto error = std::exchange(state->error, nullptr)) std::rethrow_exception(error);
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
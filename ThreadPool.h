@@ -0,0 +1,80 @@
+#ifndef PASSWORDMANAGER_THREADPOOL_H
+#define PASSWORDMANAGER_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* @brief Class representing a fixed set of worker threads that run tasks in the background.
+* Threads are started once and reused, so splitting work into tasks is cheap enough to do on every unlock.
+*/
+class ThreadPool {
+    /**
+     * The worker threads.
+     */
+    std::vector<std::thread> workers;
+    /**
+     * Tasks waiting for a free worker.
+     */
+    std::deque<std::function<void()>> tasks;
+    /**
+     * Guards the tasks and the stopping flag.
+     */
+    std::mutex mutex;
+    /**
+     * Signals the workers that a task was queued or that the pool is stopping.
+     */
+    std::condition_variable available;
+    /**
+     * Whether the workers should exit once the queue is empty.
+     */
+    bool stopping = false;
+    /**
+    @brief Runs queued tasks until the pool is stopped.
+    */
+    void work();
+public:
+    /**
+    @brief Constructs a ThreadPool and starts its workers.
+    @param threads The number of worker threads. With 0 threads, run() executes all tasks on the calling thread.
+    */
+    explicit ThreadPool(std::size_t threads);
+    /**
+    @brief Finishes the queued tasks and stops the workers.
+    */
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    /**
+    @brief Retrieves the number of worker threads.
+    @return The number of workers.
+    */
+    std::size_t size() const;
+    /**
+    @brief Queues a task to be run by a worker.
+    @param task The task to run.
+    */
+    void post(std::function<void()> task);
+    /**
+    @brief Runs a task for every index from 0 to count - 1 and waits for all of them to finish.
+    The calling thread takes part in the work, so run() makes progress even when every worker is busy.
+    @param count The number of indexes.
+    @param task The task to run for every index.
+    @throws Rethrows the first exception thrown by a task, after all tasks have finished.
+    */
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+    /**
+    @brief Retrieves the pool shared by the whole program. Together with the calling thread
+     it uses every available core.
+    @return The shared pool.
+    */
+    static ThreadPool& shared();
+};
+
+
+#endif //PASSWORDMANAGER_THREADPOOL_H
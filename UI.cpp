@@ -2,9 +2,9 @@
 #include <fstream>
 #include "UI.h"
 #include "FileEncryptor.h"
-#include <random>
 #include <filesystem>
-#include "DecryptionException.h"
+#include <algorithm>
+#include "Stats.h"
 
 using std::string, std::cout, std::cin;
 
@@ -13,48 +13,54 @@ auto UI::show() -> void {
     string file_name = getFileName();
     string password;
     while (true) {
-        try {
-            cout << "Enter the password: ";
-            cin >> password;
-            passwordList = new PasswordList(file_name, password);
-            break;
-        } catch (DecryptionException e) {
-            cout << e.what();
-        }
+        cout << "Enter the password: ";
+        cin >> password;
+        STATS_TIMER(timer, "UI::unlock");
+        auto errors = vaults.open({{file_name, password}});
+        if (errors[0].empty()) break;
+        cout << errors[0] << "\n";
     }
+    passwordList = &vaults.vault(0);
+    saver = std::make_unique<BackgroundSaver>(*passwordList);
+#ifndef _WIN32
+    saver->flushOnSignals();
+#endif
     while (true) {
         cout << "\n";
         printOptions();
         int input;
         cin >> input;
+        auto edit = saver->lock();
         switch (input) {
             case 1 : {
-                passwordList->saveData();
+                STATS_TIMER(timer, "UI::saveAndExit");
+                edit.unlock();
+                saver->flush(true);
                 break;
             }
             case 2 : {
                 addEntry();
-                passwordList->saveData();
+                save();
                 continue;
             }
             case 3 : {
                 deleteEntry();
-                passwordList->saveData();
+                save();
                 continue;
             }
             case 4 : {
                 addCategory();
-                passwordList->saveData();
+                save();
                 continue;
             }
             case 5 : {
                 deleteCategory();
-                passwordList->saveData();
+                save();
                 continue;
             }
             case 6 : {
                 editPassword();
-                passwordList->saveData();
+                save();
                 continue;
             }
             case 7 : {
@@ -65,6 +71,18 @@ auto UI::show() -> void {
                 sortPasswords();
                 continue;
             }
+            case 9 : {
+                findPasswords();
+                continue;
+            }
+            case 10 : {
+                showStatistics();
+                continue;
+            }
+            case 11 : {
+                findInAllVaults();
+                continue;
+            }
         }
         break;
     }
@@ -188,7 +206,9 @@ auto UI::printOptions() -> void {
     int count = 1;
     cout << count++ << ". Save and exit\n" << count++ << ". Add password\n" << count++
     << ". Delete password\n" << count++ << ". Add category\n" << count++ << ". Delete category\n" <<
-    count++ << ". Change password\n" << count++ << ". Search passwords\n" << count++ << ". Sort passwords\n";
+    count++ << ". Change password\n" << count++ << ". Search passwords\n" << count++ << ". Sort passwords\n" <<
+    count++ << ". Find in all categories\n" << count++ << ". Show statistics\n" << count++ <<
+    ". Find in all vaults\n";
 }
 
 auto UI::chooseCategory() -> std::string {
@@ -256,7 +276,7 @@ void UI::editPassword() {
         cout << "Chosen category is empty.";
     }
     listInCategory(category);
-    auto & entries = passwordList->getEntriesInCategory(category);
+    const auto & entries = passwordList->getEntriesInCategory(category);
     while (true) {
         int index;
         cin >> index;
@@ -268,14 +288,14 @@ void UI::editPassword() {
         int option;
         cin >> option;
         std::string newValue;
-        Entry & entry = entries[index-1];
+        const Entry & entry = entries[index-1];
         switch (option) {
             case 1 : {
                 while (true) {
                     cout << "Enter new name: ";
                     cin >> newValue;
                     if(!passwordList->entryExists(newValue, entry.getCategory())){
-                        entry.setName(newValue);
+                        passwordList->editEntry(category, index - 1, EntryField::Name, newValue);
                         break;
                     }
                     cout << "Entry with such name already exists in this category.\n";
@@ -295,19 +315,19 @@ void UI::editPassword() {
             case 3 : {
                 cout << "Enter new password: ";
                 cin >> newValue;
-                entry.setPassword(newValue);
+                passwordList->editEntry(category, index - 1, EntryField::Password, newValue);
                 break;
             }
             case 4 : {
                 cout << "Enter new login: ";
                 cin >> newValue;
-                entry.setLogin(newValue);
+                passwordList->editEntry(category, index - 1, EntryField::Login, newValue);
                 break;
             }
             case 5 : {
                 cout << "Enter new website: ";
                 cin >> newValue;
-                entry.setWebsite(newValue);
+                passwordList->editEntry(category, index - 1, EntryField::Website, newValue);
                 break;
             }
             default : {
@@ -341,19 +361,17 @@ void UI::searchPassword() {
             case 1 : {
                 cout << "Enter the name: ";
                 cin >> val;
-                for (auto entry : passwordList->getEntriesInCategory(cat)) {
-                    if(entry.getName() == val){
-                        cout << entry.getDisplayString() << "\n";
-                        found = true;
-                    }
+                if (auto entry = passwordList->findEntry(cat, val)) {
+                    cout << entry->getDisplayString() << "\n";
+                    found = true;
                 }
                 break;
             }
             case 2 : {
                 cout << "Enter the login: ";
                 cin >> val;
-                for (auto entry : passwordList->getEntriesInCategory(cat)) {
-                    if(entry.getLogin() == val){
+                for (auto entry : passwordList->findEntries(EntryField::Login, val)) {
+                    if(entry.getCategory() == cat){
                         cout << entry.getDisplayString() << "\n";
                         found = true;
                     }
@@ -363,8 +381,8 @@ void UI::searchPassword() {
             case 3 : {
                 cout << "Enter the website: ";
                 cin >> val;
-                for (auto entry : passwordList->getEntriesInCategory(cat)) {
-                    if(entry.getWebsite() == val){
+                for (auto entry : passwordList->findEntries(EntryField::Website, val)) {
+                    if(entry.getCategory() == cat){
                         cout << entry.getDisplayString() << "\n";
                         found = true;
                     }
@@ -380,6 +398,73 @@ void UI::searchPassword() {
         if(!confirm("Search by other parameters?")) break;
     }
 }
+void UI::findPasswords() {
+    while (true) {
+        cout << "1.Find text anywhere in a field\n2.Find fields starting with text\n";
+        int option;
+        cin >> option;
+        if (option != 1 && option != 2) {
+            cout << "Invalid option.\n\n";
+            continue;
+        }
+        cout << "Enter the text: ";
+        std::string val;
+        cin >> val;
+        bool found;
+        {
+            STATS_TIMER(timer, "UI::findPasswords");
+            auto matches = passwordList->search(val, option == 1 ? SearchMode::Substring : SearchMode::Prefix);
+            for (const auto& match : matches) {
+                cout << match.entry.getDisplayString() << "\n";
+            }
+            found = !matches.empty();
+        }
+        if (!found) cout << "No records found.\n\n";
+        if (!confirm("Search for other text?")) break;
+    }
+}
+
+void UI::findInAllVaults() {
+    vector<VaultManager::Credentials> others;
+    if (std::filesystem::exists("Files")) {
+        cin.ignore();
+        for (const auto &entry: std::filesystem::directory_iterator("Files")) {
+            if (vaults.isOpen(entry.path().string())) continue;
+            cout << "Enter the password of " << relative(entry.path()) << " (ENTER to skip): ";
+            string password;
+            std::getline(cin, password);
+            if (!password.empty()) others.push_back({entry.path().string(), password});
+        }
+    }
+    auto errors = vaults.open(others);
+    for (std::size_t i = 0; i < others.size(); ++i) {
+        if (!errors[i].empty()) cout << others[i].fileName << ": " << errors[i] << "\n";
+    }
+    while (true) {
+        cout << "1.Find text anywhere in a field\n2.Find fields starting with text\n";
+        int option;
+        cin >> option;
+        if (option != 1 && option != 2) {
+            cout << "Invalid option.\n\n";
+            continue;
+        }
+        cout << "Enter the text: ";
+        std::string val;
+        cin >> val;
+        bool found;
+        {
+            STATS_TIMER(timer, "UI::findInAllVaults");
+            auto matches = vaults.search(val, option == 1 ? SearchMode::Substring : SearchMode::Prefix);
+            for (const auto& [vault, match] : matches) {
+                cout << vaults.fileName(vault) << ": " << match.entry.getDisplayString() << "\n";
+            }
+            found = !matches.empty();
+        }
+        if (!found) cout << "No records found.\n\n";
+        if (!confirm("Search for other text?")) break;
+    }
+}
+
 string UI::generatePassword() {
     int number;
     while (true) {
@@ -388,18 +473,14 @@ string UI::generatePassword() {
         if(number >= 5 && number <= 100) break;
         cout << "The number has to be between 5 and 50.\n";
     }
-    vector<string> sets = {"abcdefghijklmnopqrstuvwxyz", "0123456789"};
-    if(confirm("Include uppercase letters?")) sets.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
-    if(confirm("Include special symbols?")) sets.push_back("!@#$%&");
-    string password = std::string();
+    string alphabet = string(PasswordGenerator::lowercase) + string(PasswordGenerator::digits);
+    if(confirm("Include uppercase letters?")) alphabet += PasswordGenerator::uppercase;
+    if(confirm("Include special symbols?")) alphabet += PasswordGenerator::symbols;
+    generator.setAlphabet(alphabet);
+    cout << "Strength: " << static_cast<int>(generator.entropyBits(number)) << " bits of entropy.\n";
+    string password;
     while (true) {
-        password = "";
-        std::random_device rd;
-        std::default_random_engine defEngine(rd());
-        for (int i = 0; i < number; ++i) {
-            string set = sets[std::uniform_int_distribution<int>(0, sets.size() - 1)(defEngine)];
-            password += set.at(std::uniform_int_distribution<int>(0, set.size() - 1)(defEngine));
-        }
+        password = generator.generate(number);
         cout << password << "\n";
         if (confirm("Generate another password?")) continue;
         else break;
@@ -422,17 +503,24 @@ void UI::sortPasswords() {
             parameters[i] = input;
         }
         cout << "\n";
-        vector<Entry> entries(passwordList->getAllEntries());
-        std::sort(entries.begin(), entries.end(), [&](const Entry &entry1, const Entry &entry2) -> bool {
-            return Entry::compareEntries(entry1, entry2, parameters[0], parameters[1]);
-        });
-        for (int i = 0; i < entries.size(); ++i) {
-            cout << i + 1 << ". " << entries[i].getDisplayString() << "\n";
+        {
+            int count = 1;
+            STATS_TIMER(timer, "UI::sortPasswords");
+            passwordList->forEachSorted(static_cast<EntryField>(parameters[0]),
+                                        static_cast<EntryField>(parameters[1]), [&](const EntryRef& entry) {
+                cout << count++ << ". " << entry.getDisplayString() << "\n";
+            });
         }
         cout << "\n";
         if(!confirm("Sort by different parameters?")) break;
     }
 }
 
+void UI::save() {
+    STATS_TIMER(timer, "UI::save");
+    saver->markDirty();
+}
 
-
+void UI::showStatistics() {
+    cout << Stats::instance().report();
+}
@@ -1,6 +1,10 @@
 #ifndef PASSWORDMANAGER_UI_H
 #define PASSWORDMANAGER_UI_H
+#include <memory>
+#include "BackgroundSaver.h"
 #include "PasswordList.h"
+#include "PasswordGenerator.h"
+#include "VaultManager.h"
 /**
 * @brief Class representing the user interface of the PasswordManager program.
 * The UI class provides a user interface for interacting with the PasswordManager program.
@@ -11,14 +15,30 @@
 class UI {
 private:
     /**
-     * Pointer to the PasswordList object used by the application.
+     * The vaults opened by the application: the one chosen at start, then the ones searched with it.
+     */
+    VaultManager vaults;
+    /**
+     * Pointer to the PasswordList object used by the application, the first vault.
      * */
     PasswordList* passwordList;
+    /**
+     * Saves the first vault in the background, so the menu does not wait for the disk.
+     */
+    std::unique_ptr<BackgroundSaver> saver;
+    /**
+     * Generator of the passwords offered when adding entries, seeded once for the session.
+     */
+    PasswordGenerator generator;
     /**
     @brief Prints the available options to the console.
      */
     auto printOptions() -> void;
     /**
+    @brief Hands the changes made by a menu option to the background saver.
+     */
+    void save();
+    /**
     @brief Handles adding new categories to the password list.
      */
     auto addCategory() -> void;
@@ -54,11 +74,25 @@ private:
     **/
     void searchPassword();
     /**
+    @brief Searches the name, login, website and category of all entries in all categories for a piece of text
+     and displays the matching entries, best matches first.
+    */
+    void findPasswords();
+    /**
+    @brief Opens the other vaults of the program's folder, asking for their passwords, and searches all open vaults
+     at once for a piece of text, displaying the matching entries with their vaults, best matches first.
+    */
+    void findInAllVaults();
+    /**
     @brief Prints a list of entries sorted by 2 different parameters. Possible parameters to choose from are name,
      category, login and website.
     */
     void sortPasswords();
     /**
+    @brief Prints the number of calls, bytes processed and latencies of the instrumented operations.
+    */
+    void showStatistics();
+    /**
     @brief Lists password entries in a specific category.
     @param cat The category to display.
     */
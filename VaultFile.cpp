@@ -0,0 +1,150 @@
+#include "VaultFile.h"
+#include "FileIO.h"
+#include <cerrno>
+#include <ctime>
+#include <filesystem>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+using namespace FileIO;
+
+VaultFile::VaultFile(const string &fileName) : fileName(fileName), tempFileName(fileName + ".tmp") {}
+
+bool VaultFile::exists() const {
+    return std::filesystem::exists(fileName);
+}
+
+string VaultFile::read() const {
+    int fd = ::open(fileName.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0) return "";
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || info.st_size <= static_cast<off_t>(timestampSize)) {
+        ::close(fd);
+        return "";
+    }
+    string content(info.st_size - timestampSize, '\0');
+    content.resize(readAll(fd, content.data(), content.size()));
+    ::close(fd);
+    return content;
+}
+
+VaultFile::Mapping VaultFile::map() const {
+#ifdef _WIN32
+    return {};
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return {};
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= static_cast<off_t>(timestampSize)) {
+        ::close(fd);
+        return {};
+    }
+    auto length = static_cast<std::size_t>(info.st_size);
+    void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    if (address == MAP_FAILED) return {};
+    ::madvise(address, length, MADV_SEQUENTIAL);
+    return {address, length, length - timestampSize};
+#endif
+}
+
+VaultFile::Mapping::Mapping(void *address, std::size_t length, std::size_t size)
+        : address(address), length(length), size(size) {}
+
+VaultFile::Mapping::Mapping(Mapping &&other) noexcept
+        : address(std::exchange(other.address, nullptr)), length(std::exchange(other.length, 0)),
+          size(std::exchange(other.size, 0)) {}
+
+VaultFile::Mapping &VaultFile::Mapping::operator=(Mapping &&other) noexcept {
+    std::swap(address, other.address);
+    std::swap(length, other.length);
+    std::swap(size, other.size);
+    return *this;
+}
+
+VaultFile::Mapping::~Mapping() {
+#ifndef _WIN32
+    if (address != nullptr) ::munmap(address, length);
+#endif
+}
+
+bool VaultFile::Mapping::valid() const {
+    return address != nullptr;
+}
+
+std::span<const std::byte> VaultFile::Mapping::data() const {
+    return {static_cast<const std::byte*>(address), size};
+}
+
+void VaultFile::touch() const {
+    int fd = ::open(fileName.c_str(), O_WRONLY | O_BINARY);
+    if (fd < 0) return;
+    auto size = ::lseek(fd, 0, SEEK_END);
+    auto offset = size >= static_cast<off_t>(timestampSize) ? size - static_cast<off_t>(timestampSize) : size;
+    if (::lseek(fd, offset, SEEK_SET) == offset) {
+        writeAll(fd, getTimestamp(), fileName);
+    }
+    ::close(fd);
+}
+
+void VaultFile::write(std::string_view data) const {
+    int fd = ::open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (fd < 0) throwLastError("Failed to create " + tempFileName);
+    auto timestamp = getTimestamp();
+    try {
+#ifdef __linux__
+        // Reserving the space up front keeps the file contiguous and reports a full disk before anything is written.
+        int error = ::posix_fallocate(fd, 0, static_cast<off_t>(data.size() + timestamp.size()));
+        if (error == ENOSPC) {
+            errno = error;
+            throwLastError("Failed to allocate " + tempFileName);
+        }
+#endif
+        writeAll(fd, data, tempFileName);
+        writeAll(fd, timestamp, tempFileName);
+        syncFile(fd, tempFileName);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::close(fd) != 0) throwLastError("Failed to close " + tempFileName);
+    std::filesystem::rename(tempFileName, fileName);
+    syncDirectory(fileName);
+}
+
+string VaultFile::identity() const {
+    int fd = ::open(fileName.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0) return "";
+    auto size = ::lseek(fd, 0, SEEK_END);
+    string trailer(timestampSize, '\0');
+    if (size < static_cast<off_t>(timestampSize) || ::lseek(fd, size - static_cast<off_t>(timestampSize), SEEK_SET) < 0) {
+        trailer.clear();
+    } else {
+        trailer.resize(readAll(fd, trailer.data(), trailer.size()));
+    }
+    ::close(fd);
+    return trailer + "/" + std::to_string(size);
+}
+
+string VaultFile::getTimestamp() {
+    std::time_t currentTime = std::time(nullptr);
+    // localtime shares its result between threads, and vaults may be opened on several threads at once.
+    std::tm time;
+#ifdef _WIN32
+    localtime_s(&time, &currentTime);
+#else
+    localtime_r(&currentTime, &time);
+#endif
+    const std::tm* timeInfo = &time;
+    std::string timestamp = std::to_string(timeInfo->tm_year - 100) +
+                            (timeInfo->tm_hour < 10 ? "0" : "") + std::to_string(timeInfo->tm_hour) +
+                            (timeInfo->tm_mon + 1 < 10 ? "0" : "") + std::to_string(timeInfo->tm_mon + 1) +
+                            (timeInfo->tm_min < 10 ? "0" : "") + std::to_string(timeInfo->tm_min) +
+                            (timeInfo->tm_mday < 10 ? "0" : "") + std::to_string(timeInfo->tm_mday) +
+                            (timeInfo->tm_sec < 10 ? "0" : "") + std::to_string(timeInfo->tm_sec);
+    return timestamp;
+}
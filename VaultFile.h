@@ -0,0 +1,114 @@
+#ifndef PASSWORDMANAGER_VAULTFILE_H
+#define PASSWORDMANAGER_VAULTFILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+using std::string;
+
+/**
+* @brief Class representing the file a password list is stored in.
+* The file holds the encrypted data followed by a 12 character timestamp trailer recording when the file
+* was last opened or saved. Saves never modify the file in place: the data is written to a temporary file
+* next to the vault, flushed to disk and then renamed over the vault, so a crash leaves either the old or
+* the new version intact.
+*/
+class VaultFile {
+    /**
+     * The name of the vault file.
+     */
+    string fileName;
+    /**
+     * The name of the temporary file saves are written to before replacing the vault.
+     */
+    string tempFileName;
+public:
+    /**
+     * Length of the timestamp trailer at the end of the file.
+     */
+    static constexpr std::size_t timestampSize = 12;
+    /**
+    * @brief Read-only memory mapping of the data stored in a vault file, excluding the timestamp trailer.
+    * The mapping is released when the object is destroyed.
+    */
+    class Mapping {
+        /**
+         * Start of the mapped region, or nullptr if nothing is mapped.
+         */
+        void* address = nullptr;
+        /**
+         * Length of the mapped region.
+         */
+        std::size_t length = 0;
+        /**
+         * Length of the data in the mapped region.
+         */
+        std::size_t size = 0;
+    public:
+        Mapping() = default;
+        Mapping(void* address, std::size_t length, std::size_t size);
+        Mapping(Mapping&& other) noexcept;
+        Mapping& operator=(Mapping&& other) noexcept;
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+        ~Mapping();
+        /**
+        @brief Checks if the file was mapped.
+        @return True if the mapping holds the file's data, false otherwise.
+        */
+        bool valid() const;
+        /**
+        @brief Retrieves the mapped data.
+        @return The data stored in the file without the timestamp trailer.
+        */
+        std::span<const std::byte> data() const;
+    };
+    /**
+    @brief Constructs a VaultFile object for the given file.
+    @param fileName The name of the vault file.
+    */
+    explicit VaultFile(const string& fileName);
+    /**
+    @brief Checks if the vault file exists.
+    @return True if the file exists, false otherwise.
+    */
+    bool exists() const;
+    /**
+    @brief Reads the contents of the vault file without the timestamp trailer in a single read.
+    @return The encrypted data stored in the file.
+    */
+    string read() const;
+    /**
+    @brief Maps the vault file into memory read-only.
+    @return The mapping, which is not valid if the file is missing, holds no data or cannot be mapped.
+    In that case read() has to be used instead.
+    */
+    Mapping map() const;
+    /**
+    @brief Overwrites the timestamp trailer in place with the current time, appending it if the file is too short
+     to hold one. The rest of the file is left untouched.
+    */
+    void touch() const;
+    /**
+    @brief Atomically replaces the vault file with the given data followed by a fresh timestamp trailer.
+    @param data The encrypted data to store.
+    @throws std::system_error If the data could not be written.
+    */
+    void write(std::string_view data) const;
+    /**
+    @brief Retrieves a string identifying the current version of the vault file, made of its timestamp trailer
+     and its size. It changes whenever the file is opened or saved.
+    @return The identity of the file, or an empty string if the file does not exist.
+    */
+    string identity() const;
+    /**
+    @brief Gets current date and time and converts it to a string.
+    @return A string representation of a timestamp.
+    */
+    static string getTimestamp();
+};
+
+
+#endif //PASSWORDMANAGER_VAULTFILE_H
@@ -0,0 +1,77 @@
+#include "VaultHeader.h"
+#include <algorithm>
+#include "DecryptionException.h"
+
+namespace {
+    /**
+     * The text whose HMAC is the key check. It differs from anything encrypted with the key.
+     */
+    constexpr std::string_view keyCheckText = "PasswordManager key check";
+}
+
+VaultHeader VaultHeader::generate(std::string_view password) {
+    VaultHeader header;
+    header.cipher = CipherParams::generate();
+    header.keyCheck = computeKeyCheck(header.cipher, password);
+    return header;
+}
+
+std::optional<VaultHeader> VaultHeader::read(std::span<const std::byte> data) {
+    if (data.size() < magic.size() + 1 ||
+        std::string_view(reinterpret_cast<const char*>(data.data()), magic.size()) != magic) {
+        return std::nullopt;
+    }
+    VaultHeader header;
+    header.version = std::to_integer<std::uint8_t>(data[magic.size()]);
+    if (header.version == 0 || header.version > currentVersion) {
+        throw DecryptionException("The vault was written by a newer version of the program.\n");
+    }
+    if (data.size() < header.storedSize()) throw DecryptionException();
+    auto params = data.subspan(magic.size() + 1);
+    auto cipher = CipherParams::read(params);
+    if (!cipher) throw DecryptionException("The vault was written by a newer version of the program.\n");
+    header.cipher = *cipher;
+    if (header.version >= 2) {
+        header.keyCheck.emplace();
+        std::copy_n(params.begin() + CipherParams::storedSize, Sha256::digestSize, header.keyCheck->begin());
+    }
+    if (header.version >= 5) {
+        auto compression = std::to_integer<std::uint8_t>(params[CipherParams::storedSize + Sha256::digestSize]);
+        if (compression > static_cast<std::uint8_t>(Compression::Lz4)) {
+            throw DecryptionException("The vault was written by a newer version of the program.\n");
+        }
+        header.compression = static_cast<Compression>(compression);
+    }
+    return header;
+}
+
+void VaultHeader::appendTo(string &out) const {
+    out += magic;
+    out += static_cast<char>(version);
+    cipher.appendTo(out);
+    if (keyCheck) {
+        for (auto byte : *keyCheck) out += static_cast<char>(byte);
+    }
+    if (version >= 5) out += static_cast<char>(compression);
+}
+
+std::size_t VaultHeader::storedSize() const {
+    if (version >= 5) return size;
+    return version >= 2 ? size - 1 : size - 1 - Sha256::digestSize;
+}
+
+bool VaultHeader::accepts(std::string_view password) const {
+    if (!keyCheck) return true;
+    auto expected = computeKeyCheck(cipher, password);
+    // Every byte is compared, so the time taken does not tell how much of the check matched.
+    std::byte difference{0};
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        difference |= expected[i] ^ (*keyCheck)[i];
+    }
+    return difference == std::byte{0};
+}
+
+Sha256::Digest VaultHeader::computeKeyCheck(const CipherParams &params, std::string_view password) {
+    auto key = params.deriveKey(password);
+    return Sha256::hmac(key, std::as_bytes(std::span(keyCheckText)));
+}
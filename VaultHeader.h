@@ -0,0 +1,108 @@
+#ifndef PASSWORDMANAGER_VAULTHEADER_H
+#define PASSWORDMANAGER_VAULTHEADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include "CipherEngine.h"
+#include "Sha256.h"
+
+using std::string;
+
+/**
+* @brief Codecs the records of a vault can be compressed with.
+*/
+enum class Compression : std::uint8_t {
+    None = 0,
+    /**
+     * The LZ4 block format, through Lz4.
+     */
+    Lz4 = 1
+};
+
+/**
+* @brief The unencrypted header at the start of a vault file, telling how the rest of the file is encrypted.
+* Layout: the magic bytes "PMVF", the format version (1 byte), the cipher parameters and, since version 2, the key
+* check: an HMAC of a fixed text under the key derived from the password. The key check rejects a wrong password
+* before any of the data is decrypted, and reveals nothing about the key.
+* Since version 3 the data is stored in the binary layout of BinaryVault, which keeps passwords apart from the other
+* fields since version 4; older versions store one line of comma separated fields per entry. Version 5 adds a byte
+* after the key check naming the codec the records are compressed with before they are encrypted. Version 6 stores
+* every category in a segment of its own, so saves only encode the categories that changed.
+* Files written before the header existed start directly with data XORed with the password. They are recognized by
+* not starting with the magic bytes, and are given a header when next saved.
+*/
+struct VaultHeader {
+    /**
+     * Marks the start of a vault file with a header.
+     */
+    static constexpr std::string_view magic = "PMVF";
+    /**
+     * The format version written by this program.
+     */
+    static constexpr std::uint8_t currentVersion = 6;
+    /**
+     * The first format version storing the data in the binary layout.
+     */
+    static constexpr std::uint8_t binaryVersion = 3;
+    /**
+     * The first format version storing every category in a segment of its own.
+     */
+    static constexpr std::uint8_t segmentedVersion = 6;
+    /**
+     * Size of the header written by this program in bytes.
+     */
+    static constexpr std::size_t size = magic.size() + 1 + CipherParams::storedSize + Sha256::digestSize + 1;
+    std::uint8_t version = currentVersion;
+    CipherParams cipher;
+    /**
+     * The key check, or an empty optional for version 1 headers, which do not have one.
+     */
+    std::optional<Sha256::Digest> keyCheck;
+    /**
+     * The codec the records are compressed with. Always None before version 5.
+     */
+    Compression compression = Compression::None;
+    /**
+    @brief Creates the header for a new version of a file, with a new salt and nonce.
+    @param password The password of the file.
+    @return The header.
+    */
+    static VaultHeader generate(std::string_view password);
+    /**
+    @brief Reads the header at the start of a vault file.
+    @param data The contents of the file.
+    @return The header, or an empty optional if the file was written before headers existed.
+    @throws DecryptionException If the file was written by a newer version of the program or the header is damaged.
+    */
+    static std::optional<VaultHeader> read(std::span<const std::byte> data);
+    /**
+    @brief Appends the header to a string.
+    @param out The string to append to.
+    */
+    void appendTo(string& out) const;
+    /**
+    @brief Retrieves the size of the header as stored in its file, which depends on its version.
+    @return The size in bytes.
+    */
+    std::size_t storedSize() const;
+    /**
+    @brief Checks a password against the key check in constant time. Headers without a key check accept any password.
+    @param password The password to check.
+    @return True if the password may be the one the file was written with, false if it is certainly wrong.
+    */
+    bool accepts(std::string_view password) const;
+    /**
+    @brief Computes the key check of a password.
+    @param params The cipher parameters the key is derived with.
+    @param password The password.
+    @return The key check.
+    */
+    static Sha256::Digest computeKeyCheck(const CipherParams& params, std::string_view password);
+};
+
+
+#endif //PASSWORDMANAGER_VAULTHEADER_H
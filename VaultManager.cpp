@@ -0,0 +1,119 @@
+#include "VaultManager.h"
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include "Stats.h"
+
+namespace {
+    /**
+    @brief Checks if two file names refer to the same file, even when written differently.
+    */
+    bool sameFile(const string& a, const string& b) {
+        std::error_code error;
+        auto equivalent = std::filesystem::equivalent(a, b, error);
+        return error ? a == b : equivalent;
+    }
+
+    /**
+    @brief Retrieves the message of an exception without the line break some messages end with.
+    */
+    string reason(const std::exception& e) {
+        string message = e.what();
+        if (message.ends_with('\n')) message.pop_back();
+        return message;
+    }
+}
+
+VaultManager::VaultManager(ThreadPool &pool) : pool(pool) {}
+
+vector<string> VaultManager::open(const vector<Credentials> &vaults) {
+    STATS_TIMER(timer, "VaultManager::open");
+    vector<string> errors(vaults.size());
+    vector<std::unique_ptr<PasswordList>> opened(vaults.size());
+    for (std::size_t i = 0; i < vaults.size(); ++i) {
+        bool duplicate = isOpen(vaults[i].fileName) || std::any_of(vaults.begin(), vaults.begin() + i, [&](auto& v) {
+            return sameFile(v.fileName, vaults[i].fileName);
+        });
+        if (duplicate) errors[i] = "The vault is already open";
+    }
+    // Every vault also loads its file on the pool; run() lets the waiting threads help, so nesting cannot stall.
+    pool.run(vaults.size(), [&](std::size_t i) {
+        if (!errors[i].empty()) return;
+        try {
+            opened[i] = std::make_unique<PasswordList>(vaults[i].fileName, vaults[i].password, pool);
+        } catch (const std::exception& e) {
+            errors[i] = reason(e);
+        }
+    });
+    for (std::size_t i = 0; i < vaults.size(); ++i) {
+        if (!opened[i]) continue;
+        fileNames.push_back(vaults[i].fileName);
+        lists.push_back(std::move(opened[i]));
+    }
+    return errors;
+}
+
+void VaultManager::close(std::size_t vault) {
+    fileNames.erase(fileNames.begin() + static_cast<std::ptrdiff_t>(vault));
+    lists.erase(lists.begin() + static_cast<std::ptrdiff_t>(vault));
+}
+
+std::size_t VaultManager::size() const {
+    return lists.size();
+}
+
+bool VaultManager::isOpen(const string &fileName) const {
+    return std::ranges::any_of(fileNames, [&](const string& name) { return sameFile(name, fileName); });
+}
+
+const string &VaultManager::fileName(std::size_t vault) const {
+    return fileNames[vault];
+}
+
+PasswordList &VaultManager::vault(std::size_t vault) {
+    return *lists[vault];
+}
+
+vector<VaultManager::VaultMatch> VaultManager::search(std::string_view query, SearchMode mode) const {
+    STATS_TIMER(timer, "VaultManager::search");
+    vector<vector<SearchMatch>> found(lists.size());
+    pool.run(lists.size(), [&](std::size_t vault) {
+        found[vault] = lists[vault]->search(query, mode);
+    });
+    // Every vault returns its matches ranked, so merging them keeps matches of the same rank in vault order.
+    vector<VaultMatch> result;
+    for (std::size_t vault = 0; vault < found.size(); ++vault) {
+        auto middle = result.size();
+        for (const auto& match : found[vault]) {
+            result.push_back({vault, match});
+        }
+        std::inplace_merge(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(middle), result.end(),
+                           [](const VaultMatch& a, const VaultMatch& b) { return a.match.rank() < b.match.rank(); });
+    }
+    return result;
+}
+
+vector<VaultManager::VaultEntry> VaultManager::listEntries(const std::optional<string> &category) {
+    STATS_TIMER(timer, "VaultManager::listEntries");
+    vector<vector<Entry>> found(lists.size());
+    pool.run(lists.size(), [&](std::size_t vault) {
+        found[vault] = category ? lists[vault]->getEntriesInCategory(*category) : lists[vault]->getAllEntries();
+    });
+    std::size_t total = 0;
+    for (const auto& entries : found) total += entries.size();
+    vector<VaultEntry> result;
+    result.reserve(total);
+    for (std::size_t vault = 0; vault < found.size(); ++vault) {
+        for (auto& entry : found[vault]) {
+            result.push_back({vault, std::move(entry)});
+        }
+    }
+    return result;
+}
+
+void VaultManager::saveAll() {
+    STATS_TIMER(timer, "VaultManager::saveAll");
+    pool.run(lists.size(), [&](std::size_t vault) {
+        lists[vault]->saveData();
+    });
+}
@@ -0,0 +1,119 @@
+#ifndef PASSWORDMANAGER_VAULTMANAGER_H
+#define PASSWORDMANAGER_VAULTMANAGER_H
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PasswordList.h"
+#include "ThreadPool.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Class keeping several vaults open at once, each with its own password, and querying all of them together.
+* Operations across the vaults run as one task per vault on a thread pool, and wait until every vault is done.
+* Every vault is handled by a single task, so no password list is used by two threads at once.
+*/
+class VaultManager {
+public:
+    /**
+    * @brief A vault to open.
+    */
+    struct Credentials {
+        string fileName;
+        string password;
+    };
+    /**
+    * @brief An entry found by a search, together with the vault holding it.
+    */
+    struct VaultMatch {
+        std::size_t vault;
+        SearchMatch match;
+    };
+    /**
+    * @brief A copy of an entry, together with the vault holding it.
+    */
+    struct VaultEntry {
+        std::size_t vault;
+        Entry entry;
+    };
+private:
+    /**
+     * The threads the vaults are opened and queried on.
+     */
+    ThreadPool& pool;
+    /**
+     * The files of the open vaults, in the order they were opened.
+     */
+    vector<string> fileNames;
+    /**
+     * The open vaults, in the same order as their files.
+     */
+    vector<std::unique_ptr<PasswordList>> lists;
+public:
+    /**
+    @brief Constructs a VaultManager without any open vault.
+    @param pool The threads the vaults are opened and queried on.
+    */
+    explicit VaultManager(ThreadPool& pool = ThreadPool::shared());
+    /**
+    @brief Opens vaults concurrently, adding the ones that could be opened after the vaults already open.
+    @param vaults The vaults to open.
+    @return For every vault to open, an empty string if it was opened, or else the reason it could not be: a wrong
+     password, a damaged file or a file that is already open.
+    */
+    vector<string> open(const vector<Credentials>& vaults);
+    /**
+    @brief Closes a vault. The vaults after it move one place forward.
+    @param vault The index of the vault.
+    */
+    void close(std::size_t vault);
+    /**
+    @brief Retrieves the number of open vaults.
+    @return The number of vaults.
+    */
+    std::size_t size() const;
+    /**
+    @brief Checks if a file is open as a vault.
+    @param fileName The file to check.
+    @return True if the file is open, false otherwise.
+    */
+    bool isOpen(const string& fileName) const;
+    /**
+    @brief Retrieves the file of an open vault.
+    @param vault The index of the vault.
+    @return The file name the vault was opened with.
+    */
+    const string& fileName(std::size_t vault) const;
+    /**
+    @brief Retrieves an open vault.
+    @param vault The index of the vault.
+    @return The password list of the vault, valid until the vault is closed.
+    */
+    PasswordList& vault(std::size_t vault);
+    /**
+    @brief Searches all vaults at once, in the way of PasswordList::search.
+    @param query The text to look for.
+    @param mode Whether the query may appear anywhere in a field or only at its beginning.
+    @return The matching entries of all vaults, best matches first, and matches of the same rank in the order of
+     their vaults. The views are valid until their vault is modified.
+    */
+    vector<VaultMatch> search(std::string_view query, SearchMode mode = SearchMode::Substring) const;
+    /**
+    @brief Lists the entries of all vaults at once.
+    @param category The category to list in every vault that has it, or an empty optional to list every entry.
+    @return Copies of the entries, vault after vault, in the order of PasswordList::getAllEntries within a vault.
+    */
+    vector<VaultEntry> listEntries(const std::optional<string>& category = std::nullopt);
+    /**
+    @brief Saves the changes made to all vaults at once.
+    @throws Rethrows the first exception thrown while saving a vault, after all vaults were saved.
+    */
+    void saveAll();
+};
+
+
+#endif //PASSWORDMANAGER_VAULTMANAGER_H
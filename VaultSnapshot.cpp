@@ -0,0 +1,138 @@
+#include "VaultSnapshot.h"
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+VaultSnapshot::Category::Category(vector<std::shared_ptr<const Entry>> entries) : entries(std::move(entries)) {
+    names.reserve(this->entries.size());
+    for (std::size_t i = 0; i < this->entries.size(); ++i) {
+        names.try_emplace(this->entries[i]->getName(), i);
+    }
+}
+
+const vector<std::shared_ptr<const Entry>> &VaultSnapshot::Category::stored() const {
+    return entries;
+}
+
+VaultSnapshot::VaultSnapshot(Categories categories, std::shared_ptr<const PasswordSealer> sealer,
+                             std::uint64_t number)
+        : categories(std::move(categories)), sealer(std::move(sealer)), number(number) {
+    for (const auto& [name, category] : this->categories) {
+        entryCount += category->entries.size();
+    }
+}
+
+Entry VaultSnapshot::open(const Entry &stored) const {
+    if (!sealer) return stored;
+    string password;
+    sealer->openInto(stored.getPassword(), password);
+    return {stored.getCategory(), stored.getName(), password, stored.getLogin(), stored.getWebsite()};
+}
+
+std::uint64_t VaultSnapshot::version() const {
+    return number;
+}
+
+std::size_t VaultSnapshot::size() const {
+    return entryCount;
+}
+
+vector<string> VaultSnapshot::getCategories() const {
+    vector<string> result;
+    result.reserve(categories.size());
+    for (const auto& [name, category] : categories) {
+        result.push_back(name);
+    }
+    return result;
+}
+
+const VaultSnapshot::Categories &VaultSnapshot::stored() const {
+    return categories;
+}
+
+vector<Entry> VaultSnapshot::getEntriesInCategory(std::string_view cat) const {
+    vector<Entry> result;
+    auto iterator = categories.find(cat);
+    if (iterator == categories.end()) return result;
+    result.reserve(iterator->second->entries.size());
+    for (const auto& entry : iterator->second->entries) {
+        result.push_back(open(*entry));
+    }
+    return result;
+}
+
+std::optional<Entry> VaultSnapshot::findEntry(std::string_view cat, std::string_view name) const {
+    auto category = categories.find(cat);
+    if (category == categories.end()) return std::nullopt;
+    auto entry = category->second->names.find(name);
+    if (entry == category->second->names.end()) return std::nullopt;
+    return open(*category->second->entries[entry->second]);
+}
+
+vector<Entry> VaultSnapshot::findEntries(EntryField field, std::string_view value) const {
+    vector<Entry> result;
+    for (const auto& [name, category] : categories) {
+        if (field == EntryField::Name) {
+            // The index only holds the first entry of every name, so the others are found by scanning from it.
+            auto first = category->names.find(value);
+            if (first == category->names.end()) continue;
+            for (auto i = first->second; i < category->entries.size(); ++i) {
+                if (category->entries[i]->getName() == value) result.push_back(open(*category->entries[i]));
+            }
+            continue;
+        }
+        for (const auto& entry : category->entries) {
+            bool matches = field == EntryField::Login ? entry->getLogin() == value
+                           : field == EntryField::Website && entry->getWebsite() == value;
+            if (matches) result.push_back(open(*entry));
+        }
+    }
+    return result;
+}
+
+vector<Entry> VaultSnapshot::search(std::string_view query, SearchMode mode) const {
+    vector<Entry> result;
+    if (query.empty()) return result;
+    string lowered(query);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), SearchIndex::toLower);
+    using Rank = decltype(SearchMatch::rankOf(SearchMatch::Kind::Exact, EntryField::Name));
+    vector<std::pair<Rank, const Entry*>> found;
+    for (const auto& [name, category] : categories) {
+        for (const auto& entry : category->entries) {
+            const std::pair<EntryField, std::string_view> fields[] = {
+                    {EntryField::Name, entry->getName()}, {EntryField::Website, entry->getWebsite()},
+                    {EntryField::Login, entry->getLogin()}, {EntryField::Category, entry->getCategory()}};
+            std::optional<Rank> best;
+            for (auto [field, value] : fields) {
+                auto kind = SearchIndex::match(value, lowered, mode);
+                if (kind && (!best || SearchMatch::rankOf(*kind, field) < *best)) {
+                    best = SearchMatch::rankOf(*kind, field);
+                }
+            }
+            if (best) found.emplace_back(*best, entry.get());
+        }
+    }
+    std::stable_sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    result.reserve(found.size());
+    for (const auto& [rank, entry] : found) {
+        result.push_back(open(*entry));
+    }
+    return result;
+}
+
+void VaultSnapshot::forEachSorted(EntryField first, EntryField second,
+                                  const std::function<void(const Entry&)>& visit) const {
+    vector<const Entry*> sorted;
+    sorted.reserve(entryCount);
+    for (const auto& [name, category] : categories) {
+        for (const auto& entry : category->entries) {
+            sorted.push_back(entry.get());
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const Entry* a, const Entry* b) {
+        return Entry::compareEntries(*a, *b, static_cast<int>(first), static_cast<int>(second));
+    });
+    for (const auto* entry : sorted) {
+        visit(open(*entry));
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef PASSWORDMANAGER_VAULTSNAPSHOT_H
+#define PASSWORDMANAGER_VAULTSNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Entry.h"
+#include "PasswordSealer.h"
+#include "SearchIndex.h"
+
+using std::string, std::vector;
+
+/**
+* @brief Immutable copy of the entries of a password list at one point in time, published by a SharedPasswordList.
+* Nothing in a snapshot changes once it is published, so any number of threads can read it at once without locking.
+* Every category is held by a shared pointer, and a change to the password list only copies the categories it
+* touches: the other categories are shared with the previous snapshot. Passwords are kept sealed with a sealer of
+* the SharedPasswordList and only decrypted into the copies of the entries handed out.
+*/
+class VaultSnapshot {
+public:
+    /**
+    * @brief The entries of a category, indexed by name. Entries are shared with the categories copied from this one.
+    */
+    class Category {
+        /**
+         * The entries of the category in insertion order, with their passwords sealed.
+         */
+        vector<std::shared_ptr<const Entry>> entries;
+        /**
+         * The position of the first entry of every name. The keys are views of the names of the entries.
+         */
+        std::unordered_map<std::string_view, std::size_t> names;
+        friend class VaultSnapshot;
+    public:
+        /**
+        @brief Constructs a Category and indexes its entries.
+        @param entries The entries of the category, with their passwords sealed.
+        */
+        explicit Category(vector<std::shared_ptr<const Entry>> entries);
+        Category(const Category&) = delete;
+        Category& operator=(const Category&) = delete;
+        /**
+        @brief Retrieves the entries of the category.
+        @return The entries in insertion order, with their passwords sealed.
+        */
+        const vector<std::shared_ptr<const Entry>>& stored() const;
+    };
+    /**
+     * Map of category names to their entries.
+     */
+    using Categories = std::map<string, std::shared_ptr<const Category>, std::less<>>;
+private:
+    Categories categories;
+    /**
+     * The sealer of the passwords, or nullptr if they are stored as they are.
+     */
+    std::shared_ptr<const PasswordSealer> sealer;
+    /**
+     * The number of the snapshot, raised by every publication.
+     */
+    std::uint64_t number;
+    std::size_t entryCount = 0;
+    /**
+    @brief Copies a stored entry with its password decrypted.
+    @param stored The entry as it is stored.
+    @return The copy.
+    */
+    Entry open(const Entry& stored) const;
+public:
+    /**
+    @brief Constructs a VaultSnapshot.
+    @param categories The categories of the snapshot.
+    @param sealer The sealer of the passwords, or nullptr if they are stored as they are.
+    @param number The number of the snapshot.
+    */
+    VaultSnapshot(Categories categories, std::shared_ptr<const PasswordSealer> sealer, std::uint64_t number);
+    /**
+    @brief Retrieves the number of the snapshot. Snapshots published later have greater numbers.
+    @return The number.
+    */
+    std::uint64_t version() const;
+    /**
+    @brief Retrieves the number of entries in the snapshot.
+    @return The number of entries.
+    */
+    std::size_t size() const;
+    /**
+    @brief Retrieves the categories of the snapshot, in the way of PasswordList::getCategories().
+    @return The category names, in order.
+    */
+    vector<string> getCategories() const;
+    /**
+    @brief Retrieves the stored entries of every category, sharing the categories that did not change since.
+    @return The categories.
+    */
+    const Categories& stored() const;
+    /**
+    @brief Retrieves the entries in a category.
+    @param cat The category name.
+    @return Copies of the entries in insertion order, or an empty vector if there is no such category.
+    */
+    vector<Entry> getEntriesInCategory(std::string_view cat) const;
+    /**
+    @brief Finds an entry by its name within a category.
+    @param cat The category of the entry.
+    @param name The name of the entry.
+    @return A copy of the entry, or an empty optional if there is no such entry.
+    */
+    std::optional<Entry> findEntry(std::string_view cat, std::string_view name) const;
+    /**
+    @brief Finds all entries whose name, login or website is equal to the given value. Names are looked up in the
+     index of every category; logins and websites are not indexed, so every entry is compared.
+    @param field The field to compare. Must be EntryField::Name, EntryField::Login or EntryField::Website.
+    @param value The value to look for.
+    @return Copies of the matching entries.
+    */
+    vector<Entry> findEntries(EntryField field, std::string_view value) const;
+    /**
+    @brief Searches the name, login, website and category of every entry for the query, ignoring case, ranked in
+     the way of PasswordList::search. A snapshot has no trigram index, so every entry is checked.
+    @param query The text to look for.
+    @param mode Whether the query may appear anywhere in a field or only at its beginning.
+    @return Copies of the matching entries, best matches first.
+    */
+    vector<Entry> search(std::string_view query, SearchMode mode = SearchMode::Substring) const;
+    /**
+    @brief Visits all entries ordered by two fields, in the order of Entry::compareEntries. Entries with equal
+     fields keep the order of their categories.
+    @param first The field to sort by. Must not be EntryField::Password.
+    @param second The field to sort entries with an equal first field by. Must not be EntryField::Password.
+    @param visit The function called with a copy of every entry.
+    */
+    void forEachSorted(EntryField first, EntryField second, const std::function<void(const Entry&)>& visit) const;
+};
+
+
+#endif //PASSWORDMANAGER_VAULTSNAPSHOT_H
@@ -1,6 +1,196 @@
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include "BatchRunner.h"
+#include "DecryptionException.h"
+#include "LookupClient.h"
+#include "LookupServer.h"
 #include "UI.h"
 
-int main() {
+/**
+@brief Reads the password of a vault from the PASSWORDMANAGER_PASSWORD environment variable, or else from the first
+line of a stream.
+@param input The stream.
+@param firstLine The number of the next line of the stream, raised if the password was read from it.
+@return The password.
+*/
+static std::string readPassword(std::istream& input, std::size_t& firstLine) {
+    std::string password;
+    if (auto variable = std::getenv("PASSWORDMANAGER_PASSWORD")) {
+        password = variable;
+    } else {
+        std::getline(input, password);
+        ++firstLine;
+    }
+    return password;
+}
+
+/**
+@brief Runs the commands of a command file, or of the standard input, against a vault and saves it once at the end.
+The password is taken from the PASSWORDMANAGER_PASSWORD environment variable, or else from the first line
+of the commands.
+@return The exit status: 0 if all commands succeeded, 1 if some failed and 2 if the vault could not be used.
+*/
+static int runBatch(const std::string& fileName, const char* commandFile) {
+    std::ifstream file;
+    if (commandFile != nullptr) {
+        file.open(commandFile);
+        if (!file) {
+            std::cerr << "Failed to open " << commandFile << "\n";
+            return 2;
+        }
+    }
+    std::istream& input = commandFile != nullptr ? file : std::cin;
+    std::size_t firstLine = 1;
+    auto password = readPassword(input, firstLine);
+    try {
+        PasswordList passwordList(fileName, password);
+        auto failed = BatchRunner(passwordList).run(input, std::cout, firstLine);
+        passwordList.saveData();
+        std::cout.flush();
+        return failed == 0 ? 0 : 1;
+    } catch (const DecryptionException& e) {
+        std::cerr << e.what();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+    }
+    return 2;
+}
+
+#ifdef __linux__
+/**
+@brief Unlocks a vault once and serves lookups in it over a Unix domain socket until SIGINT, SIGTERM or SIGHUP,
+see LookupServer. The password is read as in batch mode, from the standard input if it is not in the environment.
+@return The exit status: 0 once the server was stopped, 2 if the vault does not exist or the vault or the socket
+ could not be used.
+*/
+static int runServer(const std::string& fileName, const std::string& socketPath) {
+    // A missing file would open as an empty vault that accepts any password, and every lookup would find nothing.
+    if (!std::filesystem::exists(fileName)) {
+        std::cerr << "No vault " << fileName << "\n";
+        return 2;
+    }
+    std::size_t firstLine = 1;
+    auto password = readPassword(std::cin, firstLine);
+    try {
+        PasswordList passwordList(fileName, password);
+        password.assign(password.size(), '\0');
+        LookupServer server(passwordList, socketPath);
+        server.stopOnSignals();
+        std::cerr << "Serving " << fileName << " on " << socketPath << "\n";
+        server.run();
+        std::cerr << "Served " << server.requestCount() << " requests\n";
+        return 0;
+    } catch (const DecryptionException& e) {
+        std::cerr << e.what();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+    }
+    return 2;
+}
+
+/**
+@brief Sends one request to a running server and prints its JSON response.
+@param socketPath The socket file of the server.
+@param arguments The command and its arguments.
+@return The exit status: 0 if the request succeeded, 1 if it failed and 2 if the server could not be reached.
+*/
+static int runQuery(const std::string& socketPath, const std::vector<std::string_view>& arguments) {
+    std::string request;
+    for (auto argument : arguments) {
+        if (!request.empty()) request += '\t';
+        request += argument;
+    }
+    try {
+        auto response = LookupClient(socketPath).request(request);
+        std::cout << response << "\n";
+        return LookupClient::succeeded(response) ? 0 : 1;
+    } catch (const std::system_error& e) {
+        std::cerr << e.what() << "\n";
+    }
+    return 2;
+}
+
+/**
+@brief Measures a running server with the requests read from the standard input, one per line with the arguments
+separated by tabs, and prints the number of requests per second and the latencies as JSON.
+@return The exit status: 0 if every request succeeded, 1 if some failed and 2 if the test could not run.
+*/
+static int runLoadTest(const std::string& socketPath, std::size_t connections, std::size_t requestsPerConnection) {
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line[0] != '#') requests.push_back(line);
+    }
+    if (requests.empty()) {
+        std::cerr << "No requests were given on the standard input\n";
+        return 2;
+    }
+    try {
+        auto report = LookupClient::loadTest(socketPath, requests, connections, requestsPerConnection);
+        std::cout << "{\"connections\":" << connections << ",\"requests\":" << report.requests
+                  << ",\"failed\":" << report.failed << ",\"seconds\":" << report.seconds
+                  << ",\"requests_per_second\":" << report.requestsPerSecond()
+                  << ",\"p50_us\":" << report.latency(0.5) / 1e3 << ",\"p99_us\":" << report.latency(0.99) / 1e3
+                  << ",\"max_us\":" << report.latency(1) / 1e3 << "}\n";
+        return report.failed == 0 ? 0 : 1;
+    } catch (const std::system_error& e) {
+        std::cerr << e.what() << "\n";
+    }
+    return 2;
+}
+
+/**
+@brief Parses a positive count given on the command line.
+@return The count, or 0 if the argument is not a positive number.
+*/
+static std::size_t parseCount(std::string_view argument) {
+    std::size_t count = 0;
+    auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), count);
+    return error == std::errc() && end == argument.data() + argument.size() ? count : 0;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string_view(argv[1]) == "--batch") {
+        if (argc < 3 || argc > 4) {
+            std::cerr << "Usage: " << argv[0] << " --batch <vault file> [<command file>]\n";
+            return 2;
+        }
+        return runBatch(argv[2], argc == 4 ? argv[3] : nullptr);
+    }
+#ifdef __linux__
+    if (argc >= 2 && std::string_view(argv[1]) == "--serve") {
+        if (argc < 3 || argc > 4) {
+            std::cerr << "Usage: " << argv[0] << " --serve <vault file> [<socket file>]\n";
+            return 2;
+        }
+        return runServer(argv[2], argc == 4 ? argv[3] : LookupServer::defaultSocketPath());
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--query") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --query <socket file> <command> [<argument>...]\n";
+            return 2;
+        }
+        return runQuery(argv[2], std::vector<std::string_view>(argv + 3, argv + argc));
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--load-test") {
+        std::size_t connections = argc >= 4 ? parseCount(argv[3]) : 4;
+        std::size_t requests = argc >= 5 ? parseCount(argv[4]) : 10'000;
+        if (argc < 3 || argc > 5 || connections == 0 || requests == 0) {
+            std::cerr << "Usage: " << argv[0]
+                      << " --load-test <socket file> [<connections> [<requests per connection>]] < requests\n";
+            return 2;
+        }
+        return runLoadTest(argv[2], connections, requests);
+    }
+#endif
     auto ui = UI();
     ui.show();
 }